@@ -18,6 +18,65 @@
 
 //these enum values correspond with the value required by the microprocessor UART register definitions to configure parity
 typedef enum {UART_PARITY_EVEN = 0, UART_PARITY_ODD, UART_PARITY_SPACE, UART_PARITY_MARK, UART_PARITY_NONE} uart_parity_selection_t;
+
+/* selects what copy_packet_into_Tx_buffer_and_transmit() does when the packet doesn't fit in the free space of the Tx buffer.
+   TX_OVERFLOW_ALL_OR_NOTHING rejects the whole packet, TX_OVERFLOW_ACCEPT_PARTIAL accepts as many bytes as fit */
+typedef enum {TX_OVERFLOW_ALL_OR_NOTHING = 0, TX_OVERFLOW_ACCEPT_PARTIAL} tx_overflow_mode_t;
+
+/* selects how the Rx PDC wraps back around to the beginning of the Rx circular buffer.
+   RX_PDC_MODE_NO_NEXT re-initializes the PDC from the ISR once the buffer is full. RX_PDC_MODE_WITH_NEXT keeps the PDC next pointer
+   registers loaded with the buffer, so the PDC wraps on its own and the ISR only has to reload the next pointer registers */
+typedef enum {RX_PDC_MODE_NO_NEXT = 0, RX_PDC_MODE_WITH_NEXT} rx_pdc_mode_t;
+
+//signature of the functions the service calls back into the application with. The context pointer is whatever was supplied when the callback was registered
+typedef void (*serial_circular_buffer_callback_t)(void *callback_context);
+
+//records when the Rx byte count reached a given value, as kept in the optional Rx timestamp buffer (see enable_rx_timestamps())
+typedef struct
+{
+	uint32_t	number_of_received_bytes;		//lower 32 bits of get_total_number_of_received_bytes() when the timestamp was taken
+	uint32_t	timestamp;						//core clock cycle count when the timestamp was taken
+} rx_timestamp_t;
+
+//describes a block of memory the PDC transmits directly, without copying it into the Tx buffer (see enqueue_tx_descriptor())
+typedef struct
+{
+	const char	*data;
+	uint32_t	size;
+	serial_circular_buffer_callback_t	callback;		//invoked from the ISR once the block has been transmitted and its memory can be reused. May be NULL
+	void		*callback_context;
+	uint32_t	tx_buffer_position;						//Tx head index when the block was queued. The block is transmitted once the Tx tail index reaches it
+	volatile bool	ready;								//set once the descriptor has been completely filled in, so the ISR can act on it
+} tx_descriptor_t;
+
+//a frame that's fixed at compile time, such as an ack or heartbeat, transmitted straight from flash (see transmit_constant_frame())
+typedef struct
+{
+	const char	*data;
+	uint32_t	size;
+} tx_constant_frame_t;
+
+/*declares a constant frame from a string literal, e.g. SERIAL_CONSTANT_FRAME(heartbeat_frame, "\x02HB\x03");
+  Both the frame and its bytes are const, so the linker places them in flash. The literal's terminating null isn't part of the frame */
+#define SERIAL_CONSTANT_FRAME(name, string_literal)		static const char name##_bytes[] = string_literal;	\
+														static const tx_constant_frame_t name = { name##_bytes, sizeof(name##_bytes) - 1 }
+
+//returned by the Rx search functions when the requested byte isn't present in the unread bytes
+#define RX_BYTE_NOT_FOUND		(0xFFFFFFFF)
+
+#define IS_POWER_OF_TWO(value)	(((value) != 0) && (((value) & ((value) - 1)) == 0))
+
+//describes a region of a circular buffer as it resides in memory. The second block is only used when the region wraps around the end of the buffer
+typedef struct
+{
+	char		*first_block_ptr;
+	uint32_t	first_block_size;
+	char		*second_block_ptr;
+	uint32_t	second_block_size;
+} circular_buffer_spans_t;
+
+typedef circular_buffer_spans_t rx_buffer_spans_t;		//unread bytes in the Rx circular buffer, see peek_spans()
+typedef circular_buffer_spans_t tx_buffer_spans_t;		//space reserved in the Tx circular buffer, see reserve_tx()
 	
 
 	
@@ -40,6 +99,8 @@ class serial_circular_buffer : public Icomms_circular_buffer
 		 * @param Tx_buffer_size_in_bytes size of the outgoing serial byte buffer, in bytes
 		 * @param baud_rate UART baud rate, in base units of bits/second. Default baud is 115,200
 		 * @param parity integer value used by microprocessor UART register to configure parity as defined by uart_parity_selection_t. Default value is no parity.
+		 * @param rx_pdc_mode selects how the Rx PDC wraps around the Rx buffer as defined by rx_pdc_mode_t. RX_PDC_MODE_WITH_NEXT should be used at high baud rates,
+		 *		  where bytes could otherwise arrive before the ISR has had a chance to re-initialize the PDC. Default value is RX_PDC_MODE_NO_NEXT.
 		 * 
 		 * @return void
 		 */
@@ -49,7 +110,8 @@ class serial_circular_buffer : public Icomms_circular_buffer
 				  char *Tx_buffer_ptr,
 				  uint32_t Tx_buffer_size_in_bytes,
 				  uint32_t baud_rate = 115200, 
-				  uart_parity_selection_t parity = UART_PARITY_NONE);
+				  uart_parity_selection_t parity = UART_PARITY_NONE,
+				  rx_pdc_mode_t rx_pdc_mode = RX_PDC_MODE_NO_NEXT);
 
 		/**
 		 * @brief returns the latest incoming byte from the circular buffer
@@ -73,6 +135,287 @@ class serial_circular_buffer : public Icomms_circular_buffer
 		 */
 		uint32_t	get_number_of_unread_bytes();
 		
+		/**
+		 * @brief copies as many unread bytes as will fit out of the incoming circular buffer
+		 * 
+		 * This function is the bulk equivalent of calling get_latest_byte() in a loop. The unread region is copied
+		 * out with at most two block copies (one when the data is contiguous, two when it wraps around the end of 
+		 * the buffer), and the tail index is only updated once, after the copy has completed.
+		 * 
+		 * @param destination_buffer pointer to memory the unread bytes will be copied into
+		 * @param max_number_of_bytes the maximum number of bytes destination_buffer can hold
+		 * 
+		 * @return uint32_t the number of bytes copied into destination_buffer
+		 */
+		uint32_t	read_bytes(char* destination_buffer, uint32_t max_number_of_bytes);
+		
+		/**
+		 * @brief describes the unread bytes in place, without copying or consuming them
+		 * 
+		 * Fills in up to two (pointer, size) blocks that point directly into the Rx circular buffer. When the unread 
+		 * bytes wrap around the end of the buffer, the first block runs to the end of the buffer and the second block
+		 * starts at the beginning of it; otherwise the second block is empty. The bytes remain unread until consume() is called,
+		 * so a decoder can parse them in place and only then release them.
+		 * 
+		 * @param spans pointer to the structure that will be filled in with the unread blocks
+		 * 
+		 * @return uint32_t the total number of unread bytes described by spans
+		 */
+		uint32_t	peek_spans(rx_buffer_spans_t *spans);
+		
+		/**
+		 * @brief returns an unread byte without consuming it
+		 * 
+		 * Unlike get_latest_byte(), this function leaves the tail index untouched, so length prefixed protocols 
+		 * can inspect header bytes before deciding whether a complete frame has arrived.
+		 * The caller is responsible for making sure offset is less than get_number_of_unread_bytes().
+		 * 
+		 * @param offset offset of the byte from the oldest unread byte
+		 * 
+		 * @return char the unread byte at offset
+		 */
+		char		peek_at(uint32_t offset);
+		
+		/**
+		 * @brief copies unread bytes out of the incoming circular buffer without consuming them
+		 * 
+		 * Handles unread bytes that wrap around the end of the buffer. The number of bytes copied is clamped
+		 * to the number of unread bytes at or after offset.
+		 * 
+		 * @param offset offset of the first byte to copy from the oldest unread byte
+		 * @param destination_buffer pointer to memory the bytes will be copied into
+		 * @param number_of_bytes the number of bytes to copy
+		 * 
+		 * @return uint32_t the number of bytes copied into destination_buffer
+		 */
+		uint32_t	peek_copy(uint32_t offset, char* destination_buffer, uint32_t number_of_bytes);
+		
+		/**
+		 * @brief supplies the scratch buffer contiguous_view() uses for unread bytes that wrap around the end of the Rx buffer
+		 * 
+		 * @param scratch_buffer pointer to the scratch buffer, typically sized for the largest frame the application parses
+		 * @param scratch_buffer_size size of the scratch buffer, in bytes
+		 * 
+		 * @return void
+		 */
+		void		set_contiguous_view_buffer(char *scratch_buffer, uint32_t scratch_buffer_size);
+		
+		/**
+		 * @brief returns a pointer to the oldest unread bytes as one contiguous block, without consuming them
+		 * 
+		 * When the requested bytes don't wrap around the end of the Rx buffer, which is the usual case, the pointer
+		 * points directly into the Rx buffer and nothing is copied. Only when they do wrap are they copied into the 
+		 * scratch buffer supplied with set_contiguous_view_buffer(). Either way, the bytes remain unread until consume() is called,
+		 * and the pointer is only valid until then.
+		 * 
+		 * @param number_of_bytes the number of unread bytes needed in one contiguous block
+		 * 
+		 * @return const char* pointer to the bytes, or NULL if fewer bytes are unread, or they wrap and don't fit in the scratch buffer
+		 */
+		const char*	contiguous_view(uint32_t number_of_bytes);
+		
+		/**
+		 * @brief marks unread bytes as read
+		 * 
+		 * Advances the Rx tail index past bytes that have already been processed in place (see peek_spans()).
+		 * The number of bytes is clamped to the number of unread bytes in the buffer.
+		 * 
+		 * @param number_of_bytes the number of unread bytes to release
+		 * 
+		 * @return uint32_t the number of bytes actually released
+		 */
+		uint32_t	consume(uint32_t number_of_bytes);
+		
+		/**
+		 * @brief discards unread bytes without reading them
+		 * 
+		 * Intended for parsers that reject a frame or need to resynchronize after line noise. The tail index is moved 
+		 * directly, clamped to the current head index, so discarding takes the same amount of time regardless of the number of bytes.
+		 * 
+		 * @param number_of_bytes the number of unread bytes to discard
+		 * 
+		 * @return uint32_t the number of bytes actually discarded
+		 */
+		uint32_t	skip(uint32_t number_of_bytes);
+		
+		/**
+		 * @brief discards every unread byte in the incoming circular buffer
+		 * 
+		 * Moves the tail index directly to the current head index. See resync_rx() for recovering from an overrun,
+		 * which does the same but also reports the bytes lost to the overrun.
+		 * 
+		 * @return uint32_t the number of unread bytes discarded
+		 */
+		uint32_t	flush_rx(void);
+		
+		/**
+		 * @brief searches the unread bytes for a delimiter without consuming them
+		 * 
+		 * The search works on a word (4 bytes) at a time wherever the unread bytes are word aligned, and
+		 * continues across the end of the circular buffer when the unread bytes wrap. This is intended for 
+		 * newline or null delimited protocols that need to locate the end of a frame before reading it out.
+		 * 
+		 * @param delimiter the byte value to search for
+		 * @param start_offset offset from the oldest unread byte at which to begin the search
+		 * 
+		 * @return uint32_t offset of the delimiter from the oldest unread byte, or RX_BYTE_NOT_FOUND
+		 */
+		uint32_t	find_byte(uint8_t delimiter, uint32_t start_offset = 0);
+		
+		/**
+		 * @brief copies one complete delimited frame out of the incoming circular buffer
+		 * 
+		 * Locates the delimiter with find_byte(), then copies every byte up to and including it with read_bytes(), 
+		 * so the tail index is only updated once per frame. If no delimiter has arrived yet, nothing is consumed.
+		 * 
+		 * If the delimiter isn't found but get_number_of_unread_bytes() is already at or above destination_buffer_size,
+		 * the frame is too long for destination_buffer and will never be returned. The caller should discard it (e.g. with consume()).
+		 * 
+		 * @param delimiter the byte value that marks the end of a frame
+		 * @param destination_buffer pointer to memory the frame, including the delimiter, will be copied into
+		 * @param destination_buffer_size the maximum number of bytes destination_buffer can hold
+		 * 
+		 * @return uint32_t the number of bytes copied into destination_buffer, or zero if no complete frame is present
+		 */
+		uint32_t	read_until(uint8_t delimiter, char* destination_buffer, uint32_t destination_buffer_size);
+		
+		/**
+		 * @brief returns the total number of bytes received since init() was called
+		 * 
+		 * The count is monotonic: it is calculated from the number of times the Rx PDC has rolled over the 
+		 * circular buffer and the current head index, so unlike the head index it never wraps back to zero.
+		 * 
+		 * @return uint64_t the total number of bytes received
+		 */
+		uint64_t	get_total_number_of_received_bytes(void);
+		
+		/**
+		 * @brief returns the total number of bytes read out of the Rx buffer since init() was called
+		 * 
+		 * @return uint64_t the total number of bytes consumed by the application
+		 */
+		uint64_t	get_total_number_of_consumed_bytes(void);
+		
+		/**
+		 * @brief reports whether the incoming bytes have caught up with or lapped the unread bytes
+		 * 
+		 * When the application falls more than one full buffer behind, the Rx head index wraps past the tail index
+		 * and get_number_of_unread_bytes() silently reports a number that is too small. This function compares the 
+		 * monotonic received and consumed byte counts instead, so the condition can't be hidden by the wrap.
+		 * 
+		 * @return bool true if unread bytes have been overwritten (or are about to be) by newer incoming bytes
+		 */
+		bool		rx_overrun(void);
+		
+		/**
+		 * @brief returns the number of unread bytes that have been overwritten by newer incoming bytes
+		 * 
+		 * @return uint32_t the number of lost bytes, or zero if no overrun has occurred
+		 */
+		uint32_t	get_number_of_lost_rx_bytes(void);
+		
+		/**
+		 * @brief discards every unread byte so the application can start parsing again from fresh data
+		 * 
+		 * Intended to be called once rx_overrun() reports the unread bytes can no longer be trusted. The tail index
+		 * is moved directly to the current head index, so this takes the same amount of time regardless of how much data was discarded.
+		 * 
+		 * @return uint64_t the number of bytes discarded, including any that were lost to the overrun
+		 */
+		uint64_t	resync_rx(void);
+		
+		/**
+		 * @brief registers a function to be called from the ISR once enough unread bytes have arrived
+		 * 
+		 * Rather than polling get_number_of_unread_bytes(), the application can register a callback that's invoked
+		 * from serial_circular_buffer_irq_handler() whenever the number of unread bytes is at or above the watermark. 
+		 * To give the ISR a chance to check, the Rx PDC is split up into transfers of check_interval_in_bytes, and the
+		 * check is made at the end of every transfer. The callback therefore fires at most check_interval_in_bytes after 
+		 * the watermark is reached, and keeps firing at the end of each transfer for as long as the unread bytes stay at or above it.
+		 * 
+		 * The new transfer size takes effect from the next Rx PDC transfer the ISR queues up. Since the callback runs in interrupt 
+		 * context, it should do no more than signal the receiving task.
+		 * 
+		 * In RX_PDC_MODE_NO_NEXT the ISR re-arms the Rx PDC at the end of every transfer, so splitting the buffer up adds a gap
+		 * at every check_interval_in_bytes where bytes are dropped if the ISR takes longer than a character time to respond.
+		 * RX_PDC_MODE_WITH_NEXT always has the following transfer queued, so it should be used with a watermark unless the
+		 * baud rate is low enough for the ISR latency to never exceed a character time.
+		 * 
+		 * @param watermark_in_bytes number of unread bytes at which the callback is invoked. Zero disables the watermark.
+		 * @param callback function to invoke. NULL disables the watermark.
+		 * @param callback_context pointer passed back to the callback, unused by the service. Default value is NULL.
+		 * @param check_interval_in_bytes size of each Rx PDC transfer. Zero selects the watermark itself. Default value is 0.
+		 * 
+		 * @return void
+		 */
+		void		set_rx_watermark(uint32_t watermark_in_bytes, serial_circular_buffer_callback_t callback, void *callback_context = NULL, uint32_t check_interval_in_bytes = 0);
+		
+		/**
+		 * @brief enables detection of the Rx line going idle, using a Timer Counter (TC) channel
+		 * 
+		 * Frames that are too short to reach the Rx watermark would otherwise sit in the Rx buffer until the next poll. 
+		 * With idle detection enabled, the TC channel interrupts once every idle_time_in_bit_times. If bytes arrived before 
+		 * the previous interrupt but none have arrived since, the line is considered idle and the callback is invoked once,
+		 * until more bytes arrive. The callback therefore fires between one and two idle times after the last byte was received.
+		 * 
+		 * The UART peripheral on this microprocessor has no receiver time-out register, which is why a TC channel is used.
+		 * The application owns the TC channel's interrupt handler, and must call rx_idle_timer_irq_handler() from it.
+		 * 
+		 * @param tc_port_base_addr microprocessor specific peripheral base address of the TC (TC_PORT_0, TC_PORT_1 or TC_PORT_2)
+		 * @param tc_channel channel number within the TC peripheral (0 to TC_CHANNELS_PER_PORT - 1)
+		 * @param idle_time_in_bit_times how long the line must be quiet, in bit times at the configured baud rate (e.g. 35 for Modbus' 3.5 characters)
+		 * @param callback function to invoke once the line goes idle
+		 * @param callback_context pointer passed back to the callback, unused by the service. Default value is NULL.
+		 * 
+		 * @return void
+		 */
+		void		enable_rx_idle_detection(tc_t tc_port_base_addr, uint32_t tc_channel, uint32_t idle_time_in_bit_times, serial_circular_buffer_callback_t callback, void *callback_context = NULL);
+		
+		/**
+		 * @brief stops the TC channel used for Rx idle line detection
+		 * 
+		 * @return void
+		 */
+		void		disable_rx_idle_detection(void);
+		
+		/**
+		 * @brief Rx idle line detection handler for the TC channel passed to enable_rx_idle_detection()
+		 * 
+		 * Unlike the UART, the TC channel used for idle detection is chosen by the application, so the service doesn't
+		 * define the TC ISR handler itself. The application must call this function from the ISR handler of that TC channel.
+		 * 
+		 * @return void
+		 */
+		void		rx_idle_timer_irq_handler(void);
+		
+		/**
+		 * @brief enables timestamping of incoming bytes
+		 * 
+		 * Each time the ISR sees new bytes have arrived (at the end of each Rx PDC transfer, and on each Rx idle detection period),
+		 * it records the current byte count alongside the DWT core clock cycle count in timestamp_buffer. The resolution of the
+		 * timestamps is therefore set by the Rx PDC transfer size (see set_rx_watermark()) and the Rx idle time.
+		 * If timestamp_buffer fills up, newer timestamps are dropped until get_rx_arrival_time() frees up space.
+		 * 
+		 * @param timestamp_buffer pointer to the buffer that will contain the timestamps
+		 * @param number_of_timestamps the number of timestamps timestamp_buffer can hold
+		 * 
+		 * @return void
+		 */
+		void		enable_rx_timestamps(rx_timestamp_t *timestamp_buffer, uint32_t number_of_timestamps);
+		
+		/**
+		 * @brief returns when the oldest unread byte arrived
+		 * 
+		 * The timestamp returned is the first one taken after the byte arrived, so it's the latest time the byte could have
+		 * arrived. Comparing it against HAL_TIMESTAMP_READ() gives how long the byte has been waiting in the Rx buffer.
+		 * Timestamps for bytes that have already been read are released as a side effect of calling this function.
+		 * 
+		 * @param timestamp pointer to where the core clock cycle count is stored
+		 * 
+		 * @return bool false if timestamps aren't enabled or no timestamp has been taken since the oldest unread byte arrived
+		 */
+		bool		get_rx_arrival_time(uint32_t *timestamp);
+		
 		/**
 		 * @brief copies a formatted serial packet into serial buffer and transmits it (non-blocking)
 		 * 
@@ -84,12 +427,275 @@ class serial_circular_buffer : public Icomms_circular_buffer
 		 * out the serial port before it returns. The function simply notifies the microprocessor that new 
 		 * data exists in the circular buffer, kicks off the autonomous transmission process, and returns.
 		 * 
+		 * Bytes that are still waiting to be transmitted, or are being transmitted by the PDC, are never overwritten. If the 
+		 * packet doesn't fit in the free space of the Tx buffer, the function waits for space up to the blocking timeout, then
+		 * either rejects the packet or accepts part of it, as configured with set_tx_overflow_mode(). By default, the packet is 
+		 * rejected without waiting.
+		 * 
 		 * @param serialized_data_to_transmit pointer to buffer containing serialized packet to be transmitted
 		 * @param number_of_bytes_to_transmit the number of bytes to be transmitted
 		 * 
+		 * @return uint32_t the number of bytes accepted for transmission
+		 */
+		uint32_t	copy_packet_into_Tx_buffer_and_transmit(char* serialized_data_to_transmit, uint32_t number_of_bytes_to_transmit);
+		
+		/**
+		 * @brief transmits an urgent frame, such as an emergency stop, ahead of everything else, interrupting the current transfer if need be
+		 * 
+		 * If the PDC is part way through a transfer, it's stopped at the next byte boundary, the urgent frame is sent, and the
+		 * interrupted transfer then resumes from the exact byte it stopped at. The urgent frame therefore goes out within one
+		 * character time, rather than after the rest of the current transfer. It isn't subject to Tx pacing.
+		 * 
+		 * The frame is transmitted directly from frame_data, which must not be modified until it has been sent; typically it's
+		 * a constant. The function can't take over the transmitter while a lower priority thread or interrupt is part way through 
+		 * starting a transfer, or while the previous urgent frame is still being sent, in which case it returns false straight 
+		 * away and the caller should retry.
+		 * 
+		 * @param frame_data pointer to the urgent frame
+		 * @param number_of_bytes the number of bytes in the frame, up to HAL_PDC_MAX_TRANSFER_SIZE
+		 * 
+		 * @return bool true if the frame is being transmitted
+		 */
+		bool		abort_and_transmit_urgent(const char *frame_data, uint32_t number_of_bytes);
+		
+		/**
+		 * @brief supplies a second, high priority Tx buffer for time critical packets, such as control replies
+		 * 
+		 * Packets queued up with copy_packet_into_priority_Tx_buffer_and_transmit() are sent at the next PDC transfer boundary,
+		 * ahead of anything waiting in the regular Tx buffer or descriptor queue. To bound how long a priority packet waits 
+		 * behind bulk data that's already being transmitted, bulk data is handed to the PDC in chunks of at most
+		 * bulk_chunk_size bytes. At 115200 baud, each byte takes about 87us on the wire.
+		 * 
+		 * @param priority_buffer pointer to the buffer that will contain outgoing priority packets
+		 * @param priority_buffer_size the size of priority_buffer in bytes
+		 * @param bulk_chunk_size the maximum number of bulk bytes per PDC transfer. Zero doesn't limit the transfer size.
+		 * 
 		 * @return void
 		 */
-		void		copy_packet_into_Tx_buffer_and_transmit(char* serialized_data_to_transmit, uint32_t number_of_bytes_to_transmit);
+		void		enable_tx_priority_lane(char *priority_buffer, uint32_t priority_buffer_size, uint32_t bulk_chunk_size);
+		
+		/**
+		 * @brief copies a formatted serial packet into the priority Tx buffer and transmits it ahead of bulk data (non-blocking)
+		 * 
+		 * The packet is always accepted or rejected as a whole, without waiting for space. Unlike 
+		 * copy_packet_into_Tx_buffer_and_transmit(), this function must only be called from one thread.
+		 * 
+		 * @param serialized_data_to_transmit pointer to buffer containing serialized packet to be transmitted
+		 * @param number_of_bytes_to_transmit the number of bytes to be transmitted
+		 * 
+		 * @return uint32_t the number of bytes accepted for transmission, either the whole packet or zero
+		 */
+		uint32_t	copy_packet_into_priority_Tx_buffer_and_transmit(const char* serialized_data_to_transmit, uint32_t number_of_bytes_to_transmit);
+		
+		/**
+		 * @brief returns the number of bytes that can currently be queued up in the Tx buffer
+		 * 
+		 * @return uint32_t the number of free bytes in the Tx buffer
+		 */
+		uint32_t	get_tx_buffer_free_space(void);
+		
+		/**
+		 * @brief copies a packet made up of several fragments into serial buffer and transmits it as one (non-blocking)
+		 * 
+		 * Intended for packets whose header, payload and CRC live in different places in memory, so they don't have to be
+		 * assembled into one buffer first. All of the fragments are copied into the Tx buffer before the head index is 
+		 * updated and the PDC is started, so the ISR never sees part of a packet. The packet is always accepted or rejected
+		 * as a whole, after waiting for space as configured with set_tx_overflow_mode().
+		 * 
+		 * @param fragments pointer to the array of fragments, in the order they're to be transmitted
+		 * @param number_of_fragments the number of fragments in the array
+		 * 
+		 * @return uint32_t the number of bytes accepted for transmission, either the whole packet or zero
+		 */
+		uint32_t	transmit_vectored(const comms_packet_fragment_t* fragments, uint32_t number_of_fragments);
+		
+		/**
+		 * @brief reserves space in the Tx buffer for the application to serialize a packet into directly
+		 * 
+		 * Fills in up to two (pointer, size) blocks that point directly into the Tx circular buffer. When the reserved space 
+		 * wraps around the end of the buffer, the first block runs to the end of the buffer and the second block starts at the 
+		 * beginning of it; otherwise the second block is empty. Nothing is transmitted until commit_tx() is called.
+		 * Several application threads may each hold a reservation at the same time; their packets are transmitted in the order
+		 * the space was reserved, once every earlier reservation has been committed. Each reservation must therefore be 
+		 * committed promptly. The reservation waits for space the same way copy_packet_into_Tx_buffer_and_transmit() does
+		 * (see set_tx_overflow_mode()), but is always all-or-nothing.
+		 * 
+		 * @param number_of_bytes the number of bytes to reserve
+		 * @param spans pointer to the structure that will be filled in with the reserved blocks
+		 * 
+		 * @return uint32_t number_of_bytes if the space was reserved, or zero if there wasn't enough free space
+		 */
+		uint32_t	reserve_tx(uint32_t number_of_bytes, tx_buffer_spans_t *spans);
+		
+		/**
+		 * @brief queues up bytes serialized into space reserved with reserve_tx() and transmits them (non-blocking)
+		 * 
+		 * Fewer bytes than were reserved may be committed, e.g. when the worst case size of a packet was reserved, and zero
+		 * cancels the reservation. The unused space is handed back only while no other thread has reserved space after it, 
+		 * since the space has to stay contiguous. If it can't be handed back, nothing is committed and false is returned; the 
+		 * reservation must then still be committed in full (padding the unused bytes), or every later packet is held up behind it.
+		 * 
+		 * @param spans the blocks filled in by reserve_tx() for this reservation
+		 * @param number_of_bytes the number of bytes to transmit, from the beginning of the reserved space
+		 * 
+		 * @return bool true if the bytes were committed, false if number_of_bytes is larger than the reservation or the unused space couldn't be handed back
+		 */
+		bool		commit_tx(const tx_buffer_spans_t *spans, uint32_t number_of_bytes);
+		
+		/**
+		 * @brief supplies the buffer used to queue up blocks of memory for zero copy transmission
+		 * 
+		 * Must be called before enqueue_tx_descriptor() is used.
+		 * 
+		 * @param descriptor_buffer pointer to the buffer that will contain the queued descriptors
+		 * @param number_of_descriptors the number of descriptors descriptor_buffer can hold. One descriptor is always left free, so this must be at least 2.
+		 * 
+		 * @return void
+		 */
+		void		enable_tx_descriptor_queue(tx_descriptor_t *descriptor_buffer, uint32_t number_of_descriptors);
+		
+		/**
+		 * @brief queues up a block of memory to be transmitted directly by the PDC, without copying it (non-blocking)
+		 * 
+		 * Intended for large blocks that already reside in memory, such as sensor data or tables in flash. The block is
+		 * transmitted in order with the bytes queued up in the Tx buffer: everything queued before this call goes out first,
+		 * and everything queued after it goes out after. The memory must not be modified until the callback has been invoked.
+		 * Like the functions that copy into the Tx buffer, this function may be called from several threads at once.
+		 * 
+		 * @param data pointer to the block to transmit
+		 * @param number_of_bytes the number of bytes to transmit
+		 * @param callback function invoked from the ISR once the block has been transmitted. May be NULL.
+		 * @param callback_context pointer passed back to the callback, unused by the service. Default value is NULL.
+		 * 
+		 * @return bool false if the descriptor queue isn't enabled or is full
+		 */
+		bool		enqueue_tx_descriptor(const char *data, uint32_t number_of_bytes, serial_circular_buffer_callback_t callback, void *callback_context = NULL);
+		
+		/**
+		 * @brief queues up a constant frame to be transmitted directly from flash, in order with the rest of the outgoing data (non-blocking)
+		 * 
+		 * The frame is never copied into the Tx buffer, so it takes up no Tx buffer space, only a descriptor, and the descriptor
+		 * queue must have been enabled with enable_tx_descriptor_queue().
+		 * 
+		 * @param frame pointer to a frame declared with SERIAL_CONSTANT_FRAME()
+		 * 
+		 * @return bool false if the descriptor queue isn't enabled or is full
+		 */
+		bool		transmit_constant_frame(const tx_constant_frame_t *frame);
+		
+		/**
+		 * @brief waits until every queued byte has been transmitted, including the last byte's stop bit(s)
+		 * 
+		 * Unlike the PDC finishing its last transfer (TXBUFE), this waits for the UART shift register to empty (TXEMPTY), so 
+		 * the baud rate can be changed, an RS-485 transceiver turned around or the processor put to sleep as soon as it returns.
+		 * Space that has been reserved with reserve_tx() but not committed yet isn't waited for. Must not be called from an 
+		 * interrupt that has a higher priority than the UART interrupt. The timeout is measured with the DWT cycle counter, 
+		 * which this function enables.
+		 * 
+		 * @param timeout_in_us how long to wait, in microseconds. Zero only checks whether the transmitter is already idle.
+		 * 
+		 * @return bool true if the transmitter is idle, false if the timeout expired first
+		 */
+		bool		flush(uint32_t timeout_in_us);
+		
+		/**
+		 * @brief registers a function to be called from the ISR each time the transmitter goes idle
+		 * 
+		 * The callback is invoked once the last queued byte has left the UART shift register (TXEMPTY), not just the PDC. 
+		 * It isn't invoked if more bytes are queued up before the shift register empties.
+		 * 
+		 * @param callback function invoked when transmission ends. NULL disables the notification.
+		 * @param callback_context pointer passed back to the callback, unused by the service. Default value is NULL.
+		 * 
+		 * @return void
+		 */
+		void		set_tx_complete_callback(serial_circular_buffer_callback_t callback, void *callback_context = NULL);
+		
+		/**
+		 * @brief enables holding back small writes to the Tx buffer, so they're transmitted together in one PDC transfer
+		 * 
+		 * While the transmitter is idle, bytes written into the Tx buffer aren't handed to the PDC until at least threshold_in_bytes
+		 * are waiting, or deadline_in_us has passed since the first of them was held back. Once the transmitter is busy, everything
+		 * queued up behind the current transfer goes out with the next one anyway. Packets in the priority Tx buffer and queued
+		 * descriptors are never held back, and flush() sends held back bytes straight away.
+		 * 
+		 * The TC channel is used as a one-shot timer for the deadline. As with enable_rx_idle_detection(), the application owns
+		 * the TC channel's interrupt handler, and must call tx_coalescing_timer_irq_handler() from it.
+		 * 
+		 * @param tc_port_base_addr microprocessor specific peripheral base address of the TC (TC_PORT_0, TC_PORT_1 or TC_PORT_2)
+		 * @param tc_channel channel number within the TC peripheral (0 to TC_CHANNELS_PER_PORT - 1)
+		 * @param threshold_in_bytes number of waiting bytes that starts a transfer straight away
+		 * @param deadline_in_us the longest a byte is held back for, in microseconds
+		 * 
+		 * @return void
+		 */
+		void		enable_tx_coalescing(tc_t tc_port_base_addr, uint32_t tc_channel, uint32_t threshold_in_bytes, uint32_t deadline_in_us);
+		
+		/**
+		 * @brief stops holding back small writes, and transmits any bytes that are currently held back
+		 * 
+		 * @return void
+		 */
+		void		disable_tx_coalescing(void);
+		
+		/**
+		 * @brief Tx coalescing deadline handler for the TC channel passed to enable_tx_coalescing()
+		 * 
+		 * The application must call this function from the ISR handler of that TC channel.
+		 * 
+		 * @return void
+		 */
+		void		tx_coalescing_timer_irq_handler(void);
+		
+		/**
+		 * @brief limits the rate bytes are transmitted at, for receivers that can't keep up with the full line rate
+		 * 
+		 * Implemented as a token bucket refilled by a TC channel: each period, up to burst_size_in_bytes bytes are released,
+		 * and each PDC transfer is limited to the bytes released so far. Once they're used up, the transmitter waits for the next
+		 * period without using the CPU. The limit applies to every Tx lane, including the priority Tx buffer, and the rest of 
+		 * the Tx path stays non-blocking. A smaller burst gives smoother output at the cost of more interrupts.
+		 * 
+		 * As with enable_rx_idle_detection(), the application owns the TC channel's interrupt handler, and must call 
+		 * tx_pacing_timer_irq_handler() from it.
+		 * 
+		 * @param tc_port_base_addr microprocessor specific peripheral base address of the TC (TC_PORT_0, TC_PORT_1 or TC_PORT_2)
+		 * @param tc_channel channel number within the TC peripheral (0 to TC_CHANNELS_PER_PORT - 1)
+		 * @param bytes_per_second the average number of bytes to transmit per second
+		 * @param burst_size_in_bytes the number of bytes released each period, and so the most ever sent back-to-back at the line rate
+		 * 
+		 * @return void
+		 */
+		void		enable_tx_pacing(tc_t tc_port_base_addr, uint32_t tc_channel, uint32_t bytes_per_second, uint32_t burst_size_in_bytes);
+		
+		/**
+		 * @brief stops the TC channel used for Tx pacing, and transmits at the full line rate again
+		 * 
+		 * @return void
+		 */
+		void		disable_tx_pacing(void);
+		
+		/**
+		 * @brief Tx pacing handler for the TC channel passed to enable_tx_pacing()
+		 * 
+		 * The application must call this function from the ISR handler of that TC channel.
+		 * 
+		 * @return void
+		 */
+		void		tx_pacing_timer_irq_handler(void);
+		
+		/**
+		 * @brief configures what copy_packet_into_Tx_buffer_and_transmit() does when a packet doesn't fit in the Tx buffer
+		 * 
+		 * When blocking, the function busy waits for the ISR to free up space, so it must not be called with a non-zero 
+		 * timeout from an interrupt that has a higher priority than the UART interrupt. The timeout is measured with the 
+		 * DWT cycle counter, which this function enables.
+		 * 
+		 * @param overflow_mode whether to reject or partially accept packets that don't fit, as defined by tx_overflow_mode_t
+		 * @param blocking_timeout_in_us how long to wait for space before applying overflow_mode, in microseconds. Zero doesn't wait.
+		 * 
+		 * @return void
+		 */
+		void		set_tx_overflow_mode(tx_overflow_mode_t overflow_mode, uint32_t blocking_timeout_in_us = 0);
 		
 		
 		/**
@@ -112,9 +718,10 @@ class serial_circular_buffer : public Icomms_circular_buffer
 		 * 
 		 * The microprocessor peripheral DMA controller works by providing its counter a 
 		 * fixed number of bytes and a pointer to a buffer in memory. As each serial byte arrives,
-		 * the PDC counter is decremented. However, the circular buffer logic requires an incrementing
-		 * head index. Therefore, this function calcualtes the head index by returning the difference
-		 * between the buffer size and the current couter value.
+		 * the PDC pointer is incremented and the PDC counter is decremented. Since the Rx buffer
+		 * may be split up into several PDC transfers (see set_rx_watermark()), the counter alone doesn't
+		 * identify the head index. Therefore, this function calculates the head index by returning the 
+		 * difference between the current PDC pointer value and the start of the buffer.
 		 * 
 		 * @param 
 		 * 
@@ -122,9 +729,66 @@ class serial_circular_buffer : public Icomms_circular_buffer
 		 */
 		uint32_t	get_rx_buffer_head_index(void);
 		
+		/**
+		 * @brief returns the size of the Rx PDC transfer that starts at the given Rx buffer index
+		 * 
+		 * Transfers are rx_pdc_transfer_size long, except where that would run past the end of the buffer.
+		 * 
+		 * @param start_index Rx buffer index the transfer starts at
+		 * 
+		 * @return uint32_t the size of the transfer, in bytes
+		 */
+		uint32_t	get_rx_transfer_size(uint32_t start_index);
+		
+		/**
+		 * @brief restarts the Rx PDC once it has run out of transfers
+		 * 
+		 * Called from the ISR when RXBUFF is set. The PDC is restarted from wherever it stopped, rolling over
+		 * to the beginning of the Rx buffer if it stopped at the end.
+		 * 
+		 * @return void
+		 */
+		void		restart_rx_pdc(void);
+		
+		/**
+		 * @brief adds the current byte count and time to the Rx timestamp buffer, if enabled
+		 * 
+		 * Called from both the UART ISR and the Rx idle TC ISR, which may preempt each other, so the buffer is 
+		 * only updated inside a critical section.
+		 * 
+		 * @param number_of_received_bytes the current value of get_total_number_of_received_bytes()
+		 * 
+		 * @return void
+		 */
+		void		record_rx_timestamp(uint64_t number_of_received_bytes);
+		
+		/**
+		 * @brief takes a consistent snapshot of the Rx roll over count and head index
+		 * 
+		 * The roll over count is updated from the ISR and the head index is updated by the PDC, so both are 
+		 * re-read until neither has changed underneath the calculation. The ISR updates the roll over count together with the
+		 * queued transfer with interrupts masked, so a snapshot taken from a TC interrupt never sees them half updated.
+		 * 
+		 * @param head_index pointer to where the head index from the snapshot is stored
+		 * 
+		 * @return uint64_t the total number of bytes received at the time of the snapshot
+		 */
+		uint64_t	get_rx_snapshot(uint32_t *head_index);
+		
+		/**
+		 * @brief wraps an index that may have run past the end of the Rx or Tx buffer back around to the beginning
+		 * 
+		 * Uses a mask rather than a division when the buffer size is a power of two, as is always the case for
+		 * static_serial_circular_buffer. Defined inline below the class so the wrap doesn't cost a call.
+		 * 
+		 * @param index the index to wrap
+		 * 
+		 * @return uint32_t the wrapped index
+		 */
+		uint32_t	wrap_rx_index(uint32_t index);
+		uint32_t	wrap_tx_index(uint32_t index);
+		
 		void		increment_rx_buffer_tail_index(uint32_t increment_index);
-		void		increment_tx_buffer_head_index(uint32_t increment_index);
-		void		increment_tx_buffer_tail_index(uint32_t increment_index);
 		
 		/**
 		 * @brief returns the number of bytes that still need to be transmitted
@@ -140,21 +804,279 @@ class serial_circular_buffer : public Icomms_circular_buffer
 		 * @return uint32_t
 		 */
 		uint32_t	get_number_of_unsent_bytes();
-		void		initiate_PDC_Tx(char *pointer_to_Tx_buffer, uint32_t bytes_to_transfer);		
+		
+		/**
+		 * @brief waits until the Tx buffer has enough free space for a packet, or the blocking timeout expires
+		 * 
+		 * @param number_of_bytes the number of bytes the packet needs
+		 * 
+		 * @return uint32_t the number of free bytes in the Tx buffer when the wait ended
+		 */
+		uint32_t	wait_for_tx_buffer_free_space(uint32_t number_of_bytes);
+		void		initiate_PDC_Tx(char *pointer_to_Tx_buffer, uint32_t bytes_to_transfer, char *pointer_to_next_Tx_buffer = NULL, uint32_t next_bytes_to_transfer = 0);		
+		
+		/**
+		 * @brief registers the calling thread as one that's writing into the Tx buffer
+		 * 
+		 * While any producer is registered, the Tx head index isn't advanced, so the ISR never transmits space that has been
+		 * reserved but not written to yet. Must be called before claim_tx_buffer_space().
+		 * 
+		 * @return void
+		 */
+		void		register_tx_producer(void);
+		
+		/**
+		 * @brief unregisters a producer, and if it was the last one, publishes all of the reserved space and starts the transmitter
+		 * 
+		 * @return void
+		 */
+		void		release_tx_producer(void);
+		
+		/**
+		 * @brief atomically reserves space at the end of the Tx buffer, without disabling interrupts
+		 * 
+		 * @param number_of_bytes the number of bytes to reserve
+		 * @param accept_partial whether to reserve however much space is free when number_of_bytes doesn't fit
+		 * @param start_index pointer to where the Tx buffer index of the reserved space is stored
+		 * 
+		 * @return uint32_t the number of bytes reserved
+		 */
+		uint32_t	claim_tx_buffer_space(uint32_t number_of_bytes, bool accept_partial, uint32_t *start_index);
+		
+		/**
+		 * @brief starts the next Tx PDC transfer if the transmitter is idle
+		 * 
+		 * The idle transmitter is claimed atomically, so only one thread, or the ISR, ever starts a transfer.
+		 * 
+		 * @param hold_small_writes whether to hold back the bytes in the Tx buffer if Tx coalescing is enabled and there aren't
+		 *        enough of them yet, arming the coalescing deadline instead
+		 * 
+		 * @return void
+		 */
+		void		start_tx_if_idle(bool hold_small_writes);
+		
+		/**
+		 * @brief fills in the spans for a number of bytes starting at the given Tx buffer index
+		 * 
+		 * @param start_index Tx buffer index of the first byte
+		 * @param number_of_bytes the number of bytes the spans describe
+		 * @param spans pointer to the structure that will be filled in
+		 * 
+		 * @return void
+		 */
+		void		get_tx_buffer_spans(uint32_t start_index, uint32_t number_of_bytes, tx_buffer_spans_t *spans);
+		
+		/**
+		 * @brief copies bytes into Tx buffer spans, continuing into the second block if the first one runs out
+		 * 
+		 * @param spans the spans being written to
+		 * @param offset offset into the spans at which to start writing
+		 * @param data pointer to the bytes to copy
+		 * @param number_of_bytes the number of bytes to copy
+		 * 
+		 * @return void
+		 */
+		void		write_tx_buffer_spans(const tx_buffer_spans_t *spans, uint32_t offset, const char *data, uint32_t number_of_bytes);
+		
+		/**
+		 * @brief hands the unsent bytes of a Tx circular buffer up to the given index over to the PDC
+		 * 
+		 * The PDC requires the data it's sending out to reside in contiguous memory. If the unsent bytes wrap around the end of
+		 * the circular buffer, the block at the end of the buffer is loaded as the current PDC transfer and the block at the 
+		 * beginning as the next PDC transfer, so both go out back-to-back with a single TXBUFE interrupt at the end.
+		 * The bytes are deducted from the Tx pacing tokens before the PDC is started.
+		 * 
+		 * @param buffer the Tx circular buffer, either the regular or the priority Tx buffer
+		 * @param buffer_size the size of buffer in bytes
+		 * @param tail_index pointer to the buffer's tail index, which is advanced past the bytes handed to the PDC
+		 * @param end_index buffer index to stop at, either the head index or the position of the next queued descriptor
+		 * @param max_number_of_bytes the maximum number of bytes to hand to the PDC
+		 * 
+		 * @return uint32_t the number of bytes handed to the PDC
+		 */
+		uint32_t	transmit_unsent_bytes(char *buffer, uint32_t buffer_size, volatile uint32_t *tail_index, uint32_t end_index, uint32_t max_number_of_bytes);
+		
+		/**
+		 * @brief starts the next Tx PDC transfer, or marks the transmitter idle if there's nothing left to send
+		 * 
+		 * Bytes in the priority Tx buffer always go first. Otherwise, decides between the next queued descriptor and the unsent
+		 * bytes in the Tx buffer, keeping them in the order they were queued up. Must only be called while the Tx PDC is idle, i.e. from the ISR on TXBUFE, or from the application
+		 * once it has claimed the idle transmitter in start_tx_if_idle().
+		 * 
+		 * @return bool true if the transmitter is still claimed (a transfer was started, or it's waiting on the pacing timer), false if it's now idle
+		 */
+		bool		start_next_tx_transfer(void);
+		
+		/**
+		 * @brief returns whether any Tx lane has bytes that haven't been handed to the PDC yet
+		 * 
+		 * @return bool true if there's anything left to transmit
+		 */
+		bool		is_tx_data_queued(void);
+		
+		/**
+		 * @brief clears tx_pacing_waiting, if it's set, as a single atomic test and clear
+		 * 
+		 * Whoever gets true back has taken over the transmitter that was left claimed while waiting on the pacing timer, and must restart it.
+		 * 
+		 * @return bool true if the transmitter was waiting on the pacing timer
+		 */
+		bool		clear_tx_pacing_waiting(void);
+		
+		/**
+		 * @brief deducts the bytes handed to the PDC from the ones released by the Tx pacing timer, if pacing is enabled
+		 * 
+		 * @param number_of_bytes the number of bytes handed to the PDC
+		 * 
+		 * @return void
+		 */
+		void		consume_tx_pacing_tokens(uint32_t number_of_bytes);
+		
+		/**
+		 * @brief releases the descriptor at the tail of the queue once all of it has been transmitted, and invokes its callback
+		 * 
+		 * @return void
+		 */
+		void		complete_tx_descriptor(void);
 		
 		uart_t		uart_peripheral_base_address;
 		pdc_t		pdc_peripheral_base_address;
 		char		*rx_buffer;			
 		uint32_t	rx_buffer_size;
+		uint32_t	rx_buffer_wrap_mask;			//rx_buffer_size - 1 if it's a power of two, otherwise 0
 		char		*pdc_tx_buffer;
 		uint32_t	tx_buffer_size;						
+		uint32_t	tx_buffer_wrap_mask;			//tx_buffer_size - 1 if it's a power of two, otherwise 0
+		rx_pdc_mode_t	rx_pdc_mode;
+		uint32_t	rx_pdc_transfer_size;
+		uint32_t	rx_watermark;
+		serial_circular_buffer_callback_t	rx_watermark_callback;
+		void		*rx_watermark_callback_context;
+		uint32_t	baud_rate;
+		tc_t		idle_timer_base_address;
+		uint32_t	idle_timer_channel;
+		serial_circular_buffer_callback_t	rx_idle_callback;
+		void		*rx_idle_callback_context;
+		uint64_t	rx_idle_last_number_of_received_bytes;
+		bool		rx_activity_since_idle;
+		rx_timestamp_t	*rx_timestamp_buffer;
+		uint32_t	rx_timestamp_buffer_size;
+		uint32_t	rx_timestamp_tail_index;
+		uint32_t	rx_last_timestamped_number_of_received_bytes;
+		tx_overflow_mode_t	tx_overflow_mode;
+		tx_descriptor_t	*tx_descriptor_queue;
+		uint32_t	tx_descriptor_queue_size;
+		uint32_t	tx_descriptor_offset;			//number of bytes of the descriptor at the tail of the queue already handed to the PDC
+		bool		tx_descriptor_in_flight;
+		uint32_t	tx_blocking_timeout_in_cycles;
+		char		*tx_priority_buffer;
+		uint32_t	tx_priority_buffer_size;
+		uint32_t	tx_bulk_chunk_size;				//maximum number of bytes per PDC transfer from the regular Tx buffer or descriptor queue
+		serial_circular_buffer_callback_t	tx_complete_callback;
+		void		*tx_complete_callback_context;
+		tc_t		tx_coalescing_timer_base_address;
+		uint32_t	tx_coalescing_timer_channel;
+		uint32_t	tx_coalescing_threshold;
+		tc_t		tx_pacing_timer_base_address;
+		uint32_t	tx_pacing_timer_channel;
+		uint32_t	tx_pacing_burst_size;
+		char		*contiguous_view_buffer;
+		uint32_t	contiguous_view_buffer_size;
 		
-		uint32_t	tx_buffer_head_index;
-		uint32_t	tx_buffer_tail_index;	
 			
 		//the following variables are declared volatile since they're modified inside an ISR
 		volatile uint32_t	rx_buffer_tail_index;
-		volatile bool	pdc_Tx_in_progress;		
+		volatile uint32_t	rx_rollover_count;
+		volatile uint32_t	rx_queued_transfer_index;
+		volatile uint32_t	rx_queued_transfer_size;
+		volatile uint32_t	rx_timestamp_head_index;
+		uint64_t	rx_bytes_consumed;
+		volatile uint32_t	tx_descriptor_head_index;
+		volatile uint32_t	tx_descriptor_tail_index;
+		volatile uint32_t	tx_buffer_tail_index;
+		volatile uint32_t	tx_buffer_release_index;		//oldest byte the PDC may still be transmitting. Bytes from here up to the tail index are in flight
+		volatile uint32_t	tx_priority_head_index;
+		volatile uint32_t	tx_priority_tail_index;
+		volatile uint32_t	tx_priority_release_index;
+		volatile uint32_t	pdc_Tx_in_progress;		//uint32_t rather than bool, so it can be claimed with an exclusive load/store
+		
+		//the following variables are shared between the threads writing into the Tx buffer, and are only updated with exclusive load/stores
+		volatile uint32_t	tx_buffer_head_index;			//end of the bytes that have been written and can be transmitted
+		volatile uint32_t	tx_buffer_reserve_index;		//end of the space reserved by producers. Bytes from the head index up to here are still being written
+		volatile uint32_t	tx_number_of_producers;			//number of threads currently writing into the Tx buffer
+		volatile uint32_t	tx_coalescing_timer_armed;
+		volatile uint32_t	tx_pacing_tokens;				//number of bytes that may still be handed to the PDC before the next pacing period
+		volatile uint32_t	tx_pacing_waiting;				//the transmitter is claimed, but waiting for the next pacing period to continue
+		volatile bool	tx_urgent_in_flight;
+		
+		//the remainder of the PDC transfer interrupted by abort_and_transmit_urgent(), resumed once the urgent frame has been sent
+		char		*tx_interrupted_pointer;
+		uint32_t	tx_interrupted_size;
+		char		*tx_interrupted_next_pointer;
+		uint32_t	tx_interrupted_next_size;
+};
+
+inline uint32_t serial_circular_buffer::wrap_rx_index(uint32_t index)
+{
+	//a mask is much cheaper than a division, but only works for power of two buffer sizes
+	if(this->rx_buffer_wrap_mask != 0)
+	{
+		return(index & this->rx_buffer_wrap_mask);
+	}
+	
+	return(index % this->rx_buffer_size);
+}
+
+inline uint32_t serial_circular_buffer::wrap_tx_index(uint32_t index)
+{
+	if(this->tx_buffer_wrap_mask != 0)
+	{
+		return(index & this->tx_buffer_wrap_mask);
+	}
+	
+	return(index % this->tx_buffer_size);
+}
+
+
+/**
+ * @brief serial circular buffer that contains its own Rx and Tx buffers, sized at compile time
+ * 
+ * Both sizes must be powers of two, which is checked at compile time, so every wrap around the end of a buffer is a mask 
+ * rather than a division. When the object is declared as a global or static, the buffers are allocated statically along with it.
+ * Apart from init() not taking the buffers, it's used exactly like serial_circular_buffer.
+ * 
+ * The sizes are not constant folded into the wraps. All of the buffer handling is shared with serial_circular_buffer, so the
+ * mask is still read from the object at run time, exactly as for a runtime sized instance with power of two buffers.
+ */
+template <uint32_t Rx_buffer_size_in_bytes, uint32_t Tx_buffer_size_in_bytes>
+class static_serial_circular_buffer : public serial_circular_buffer
+{
+	public:
+		/**
+		 * @brief initializes the UART and its respective PDC, using the buffers contained in this object
+		 * 
+		 * @param uart_port_base_addr microprocessor specific peripheral base address of the UART
+		 * @param baud_rate the baud rate of the serial port. Default value is 115200.
+		 * @param parity the parity of the serial port as defined by uart_parity_selection_t. Default value is UART_PARITY_NONE.
+		 * @param rx_pdc_mode selects how the Rx PDC wraps around the Rx buffer as defined by rx_pdc_mode_t. Default value is RX_PDC_MODE_NO_NEXT.
+		 * 
+		 * @return void
+		 */
+		void init(uart_t uart_port_base_addr, 
+				  uint32_t baud_rate = 115200, 
+				  uart_parity_selection_t parity = UART_PARITY_NONE,
+				  rx_pdc_mode_t rx_pdc_mode = RX_PDC_MODE_NO_NEXT)
+		{
+			serial_circular_buffer::init(uart_port_base_addr, this->rx_storage, Rx_buffer_size_in_bytes, this->tx_storage, Tx_buffer_size_in_bytes, baud_rate, parity, rx_pdc_mode);
+		}
+		
+	private:
+		//the compiler doesn't support static_assert, so a size that isn't a power of two declares an array of negative size instead, which fails to compile
+		typedef char rx_buffer_size_must_be_a_power_of_two[IS_POWER_OF_TWO(Rx_buffer_size_in_bytes) ? 1 : -1];
+		typedef char tx_buffer_size_must_be_a_power_of_two[IS_POWER_OF_TWO(Tx_buffer_size_in_bytes) ? 1 : -1];
+		
+		char		rx_storage[Rx_buffer_size_in_bytes];
+		char		tx_storage[Tx_buffer_size_in_bytes];
 };
 
 
@@ -16,6 +16,13 @@
 #ifndef ICOMMS_CIRCULAR_BUFFER_H_
 #define ICOMMS_CIRCULAR_BUFFER_H_
 
+//one piece of a packet that's scattered across memory, as passed to transmit_vectored()
+typedef struct
+{
+	const char	*data;
+	uint32_t	size;
+} comms_packet_fragment_t;
+
 class Icomms_circular_buffer
 {
 	public:
@@ -37,15 +44,49 @@ class Icomms_circular_buffer
 		virtual uint32_t (get_number_of_unread_bytes)(void) = 0;
 		
 		
+		/**
+		 * @brief copies up to max_number_of_bytes unread bytes out of the incoming circular buffer
+		 * 
+		 * @param destination_buffer pointer to memory the unread bytes will be copied into
+		 * @param max_number_of_bytes the maximum number of bytes destination_buffer can hold
+		 * 
+		 * @return uint32_t the number of bytes copied into destination_buffer
+		 */
+		virtual uint32_t (read_bytes)(char* destination_buffer, uint32_t max_number_of_bytes) = 0;
+		
+		
+		/**
+		 * @brief copies one complete delimited frame out of the incoming circular buffer
+		 * 
+		 * @param delimiter the byte value that marks the end of a frame
+		 * @param destination_buffer pointer to memory the frame, including the delimiter, will be copied into
+		 * @param destination_buffer_size the maximum number of bytes destination_buffer can hold
+		 * 
+		 * @return uint32_t the number of bytes copied into destination_buffer, or zero if no complete frame is present
+		 */
+		virtual uint32_t (read_until)(uint8_t delimiter, char* destination_buffer, uint32_t destination_buffer_size) = 0;
+		
+		
 		/**
 		 * @brief copies formatted serial packet into serial buffer and transmits it (non-blocking)
 		 * 
 		 * @param serialized_data_to_transmit pointer to memory containing formatted packet
 		 * @param number_of_bytes_to_transmit the number of bytes that the service will transmit
 		 * 
-		 * @return void
+		 * @return uint32_t the number of bytes accepted for transmission
+		 */
+		virtual uint32_t (copy_packet_into_Tx_buffer_and_transmit)(char* serialized_data_to_transmit, uint32_t number_of_bytes_to_transmit) = 0;
+		
+		
+		/**
+		 * @brief copies a packet made up of several fragments into serial buffer and transmits it as one (non-blocking)
+		 * 
+		 * @param fragments pointer to the array of fragments, in the order they're to be transmitted
+		 * @param number_of_fragments the number of fragments in the array
+		 * 
+		 * @return uint32_t the number of bytes accepted for transmission, either the whole packet or zero
 		 */
-		virtual void (copy_packet_into_Tx_buffer_and_transmit)(char* serialized_data_to_transmit, uint32_t number_of_bytes_to_transmit) = 0;
+		virtual uint32_t (transmit_vectored)(const comms_packet_fragment_t* fragments, uint32_t number_of_fragments) = 0;
 };
 
 
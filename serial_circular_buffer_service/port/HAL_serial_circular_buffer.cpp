@@ -61,6 +61,24 @@ void HAL_PDC_RX_INIT_NO_NEXT(pdc_t pdc_peripheral_base_address, uint32_t address
 	
 }
 
+void HAL_PDC_RX_INIT_WITH_NEXT(pdc_t pdc_peripheral_base_address, uint32_t address, uint32_t size, uint32_t next_address, uint32_t next_size)
+{
+	pdc_peripheral_base_address->PERIPH_RPR = address;
+	pdc_peripheral_base_address->PERIPH_RCR = size;
+	
+	HAL_PDC_RX_LOAD_NEXT(pdc_peripheral_base_address, next_address, next_size);
+	
+}
+
+void HAL_PDC_RX_LOAD_NEXT(pdc_t pdc_peripheral_base_address, uint32_t next_address, uint32_t next_size)
+{
+	pdc_peripheral_base_address->PERIPH_RNPR = next_address;
+	
+	//writing to the RNCR register also clears the ENDRX flag, therefore it must be written after the address
+	pdc_peripheral_base_address->PERIPH_RNCR = next_size;
+	
+}
+
 void HAL_PDC_TX_INIT_NO_NEXT(pdc_t pdc_peripheral_base_address, uint32_t address, uint32_t size)
 {
 	pdc_peripheral_base_address->PERIPH_TPR = address;
@@ -68,4 +86,75 @@ void HAL_PDC_TX_INIT_NO_NEXT(pdc_t pdc_peripheral_base_address, uint32_t address
 	//writing to the RCR register kicks off the PDC, therefore it must be written after the address
 	pdc_peripheral_base_address->PERIPH_TCR = size;
 	
-}
\ No newline at end of file
+}
+
+void HAL_PDC_TX_INIT_WITH_NEXT(pdc_t pdc_peripheral_base_address, uint32_t address, uint32_t size, uint32_t next_address, uint32_t next_size)
+{
+	pdc_peripheral_base_address->PERIPH_PTCR = PERIPH_PTCR_TXTDIS;
+	
+	pdc_peripheral_base_address->PERIPH_TPR = address;
+	pdc_peripheral_base_address->PERIPH_TCR = size;
+	pdc_peripheral_base_address->PERIPH_TNPR = next_address;
+	pdc_peripheral_base_address->PERIPH_TNCR = next_size;
+	
+	//re-enabling the transmitter transfer kicks off the PDC with both transfers queued up
+	pdc_peripheral_base_address->PERIPH_PTCR = PERIPH_PTCR_TXTEN;
+	
+}
+
+void HAL_TC_INITIALIZE_PERIODIC_INTERRUPT(tc_t tc_peripheral_base_address, uint32_t channel, uint32_t period_in_timer_clocks)
+{
+	uint32_t peripheral_id = 0;
+	
+	//TC channels are numbered consecutively across the TC peripherals, for both the peripheral ID and the IRQ number
+	if(tc_peripheral_base_address == TC_PORT_1)
+	{
+		channel += TC_CHANNELS_PER_PORT;
+	}
+	else if(tc_peripheral_base_address == TC_PORT_2)
+	{
+		channel += (2 * TC_CHANNELS_PER_PORT);
+	}
+	peripheral_id = ID_TC0 + channel;
+	
+	//enable the peripheral clock for this channel
+	if(peripheral_id < 32)
+	{
+		PMC->PMC_PCER0 = (1UL << peripheral_id);
+	}
+	else
+	{
+		PMC->PMC_PCER1 = (1UL << (peripheral_id - 32));
+	}
+	
+	//from here on, the channel number is relative to the TC peripheral again
+	channel %= TC_CHANNELS_PER_PORT;
+	
+	tc_peripheral_base_address->TC_CHANNEL[channel].TC_CCR = TC_CCR_CLKDIS;
+	tc_peripheral_base_address->TC_CHANNEL[channel].TC_IDR = 0xFFFFFFFF;
+	tc_peripheral_base_address->TC_CHANNEL[channel].TC_CMR = TC_CMR_TCCLKS_TIMER_CLOCK1 | TC_CMR_WAVE | TC_CMR_WAVSEL_UP_RC;
+	tc_peripheral_base_address->TC_CHANNEL[channel].TC_RC = period_in_timer_clocks;
+	tc_peripheral_base_address->TC_CHANNEL[channel].TC_IER = TC_IER_CPCS;
+	
+	NVIC_EnableIRQ(IRQ_type(TC0_IRQn + (peripheral_id - ID_TC0)));
+	
+	//enabling the clock and issuing a software trigger resets the counter and starts the channel
+	tc_peripheral_base_address->TC_CHANNEL[channel].TC_CCR = TC_CCR_CLKEN | TC_CCR_SWTRG;
+	
+}
+
+void HAL_TC_STOP(tc_t tc_peripheral_base_address, uint32_t channel)
+{
+	tc_peripheral_base_address->TC_CHANNEL[channel].TC_IDR = TC_IDR_CPCS;
+	tc_peripheral_base_address->TC_CHANNEL[channel].TC_CCR = TC_CCR_CLKDIS;
+	
+}
+
+void HAL_TC_RESTART(tc_t tc_peripheral_base_address, uint32_t channel)
+{
+	tc_peripheral_base_address->TC_CHANNEL[channel].TC_IER = TC_IER_CPCS;
+	
+	//enabling the clock and issuing a software trigger resets the counter and starts the channel
+	tc_peripheral_base_address->TC_CHANNEL[channel].TC_CCR = TC_CCR_CLKEN | TC_CCR_SWTRG;
+	
+}
@@ -24,8 +24,13 @@
 #define PDC_UART_PORT_1			(PDC_UART1)
 #define IRQ_type				(IRQn_Type)
 #define ENABLE_IRQ(IRQ_num)		NVIC_EnableIRQ(IRQ_num)
+#define TC_PORT_0				(TC0)
+#define TC_PORT_1				(TC1)
+#define TC_PORT_2				(TC2)
+#define TC_CHANNELS_PER_PORT	(3)
 typedef Uart* uart_t;
 typedef Pdc*  pdc_t;
+typedef Tc*   tc_t;
 
 extern uint32_t SystemCoreClock;
 
@@ -43,8 +48,16 @@ void HAL_UART_INITIAILZE(uart_t uart_peripheral_base_address, uint32_t baudrate,
 #define HAL_UART_DISABLE_TX_BUFFER_EMPTY_INTERRUPT()	(this->uart_peripheral_base_address->UART_IDR = UART_IDR_TXBUFE)
 #define HAL_UART_ENABLE_RX_BUFFER_FULL_INTERRUPT()		(this->uart_peripheral_base_address->UART_IER = UART_IER_RXBUFF)
 #define HAL_UART_DISABLE_RX_BUFFER_FULL_INTERRUPT()		(this->uart_peripheral_base_address->UART_IDR = UART_IDR_RXBUFF)
+#define HAL_UART_ENABLE_END_OF_RX_TRANSFER_INTERRUPT()	(this->uart_peripheral_base_address->UART_IER = UART_IER_ENDRX)
+#define HAL_UART_DISABLE_END_OF_RX_TRANSFER_INTERRUPT()	(this->uart_peripheral_base_address->UART_IDR = UART_IDR_ENDRX)
 #define HAL_UART_IS_RECEIVE_BUFFER_FULL()				(this->uart_peripheral_base_address->UART_SR & UART_SR_RXBUFF)
+#define HAL_UART_IS_END_OF_RX_TRANSFER()				(this->uart_peripheral_base_address->UART_SR & UART_SR_ENDRX)
 #define HAL_UART_IS_TRANSMIT_BUFFER_EMPTY()				(this->uart_peripheral_base_address->UART_SR & UART_SR_TXBUFE)
+#define HAL_UART_IS_TX_BUFFER_EMPTY_INTERRUPT_ENABLED()	(this->uart_peripheral_base_address->UART_IMR & UART_IMR_TXBUFE)
+#define HAL_UART_ENABLE_TX_EMPTY_INTERRUPT()			(this->uart_peripheral_base_address->UART_IER = UART_IER_TXEMPTY)
+#define HAL_UART_DISABLE_TX_EMPTY_INTERRUPT()			(this->uart_peripheral_base_address->UART_IDR = UART_IDR_TXEMPTY)
+#define HAL_UART_IS_TRANSMITTER_EMPTY()					(this->uart_peripheral_base_address->UART_SR & UART_SR_TXEMPTY)		//set once the last byte has left the shift register, unlike TXBUFE
+#define HAL_UART_IS_TX_EMPTY_INTERRUPT_ENABLED()		(this->uart_peripheral_base_address->UART_IMR & UART_IMR_TXEMPTY)
 #define HAL_UART_SET_BUAD(rate)							(this->uart_peripheral_base_address->UART_BRGR = UART_BRGR_CD((uint32_t)(SystemCoreClock/((rate)*16))))
 
 
@@ -70,6 +83,40 @@ void HAL_UART_INITIAILZE(uart_t uart_peripheral_base_address, uint32_t baudrate,
 void HAL_PDC_RX_INIT_NO_NEXT(pdc_t pdc_peripheral_base_address, uint32_t address, uint32_t size);
 
 
+/**
+ * @brief Initializes the UART Rx PDC module, including the next pointer and next counter registers
+ * 
+ * This function initializes the Rx PDC the same way HAL_PDC_RX_INIT_NO_NEXT does, but also loads the 
+ * next pointer and next counter registers. When the current counter reaches zero, the PDC automatically
+ * switches over to the next buffer without any software intervention, so no incoming bytes are missed
+ * while the serial_circular_buffer_irq_handler is waiting to run.
+ * 
+ * @param pdc_peripheral_base_address base memory address for the microprocessor UART specific PDC peripheral
+ * @param address address to the buffer in memory where the PDC will automatically transfer incoming bytes
+ * @param size the size of the reception buffer, in bytes
+ * @param next_address address to the buffer the PDC will switch to once the current transfer completes
+ * @param next_size the size of the next reception buffer, in bytes
+ * 
+ * @return void
+ */
+void HAL_PDC_RX_INIT_WITH_NEXT(pdc_t pdc_peripheral_base_address, uint32_t address, uint32_t size, uint32_t next_address, uint32_t next_size);
+
+
+/**
+ * @brief Reloads only the next pointer and next counter registers of the UART Rx PDC module
+ * 
+ * Called from serial_circular_buffer_irq_handler each time the PDC has switched over to the next buffer,
+ * so the following switch over is already queued up before the current transfer completes.
+ * 
+ * @param pdc_peripheral_base_address base memory address for the microprocessor UART specific PDC peripheral
+ * @param next_address address to the buffer the PDC will switch to once the current transfer completes
+ * @param next_size the size of the next reception buffer, in bytes
+ * 
+ * @return void
+ */
+void HAL_PDC_RX_LOAD_NEXT(pdc_t pdc_peripheral_base_address, uint32_t next_address, uint32_t next_size);
+
+
 /**
  * @brief Initializes the UART Tx PDC module
  * 
@@ -91,13 +138,99 @@ void HAL_PDC_RX_INIT_NO_NEXT(pdc_t pdc_peripheral_base_address, uint32_t address
  */
 void HAL_PDC_TX_INIT_NO_NEXT(pdc_t pdc_peripheral_base_address, uint32_t address, uint32_t size);
 
+
+/**
+ * @brief Initializes the UART Tx PDC module, including the next pointer and next counter registers
+ * 
+ * This function initializes the Tx PDC the same way HAL_PDC_TX_INIT_NO_NEXT does, but also loads the next
+ * pointer and next counter registers. In the context of the serial circular buffer service, this function is called
+ * when the bytes to be transmitted wrap around the end of the circular buffer: the block at the end of the buffer is
+ * loaded as the current transfer and the block at the beginning as the next transfer, so the PDC streams both
+ * back-to-back without waiting for the serial_circular_buffer_irq_handler in between.
+ * 
+ * The Tx PDC is briefly disabled while the registers are loaded, so the current transfer can't complete before the 
+ * next transfer has been queued up. It must therefore only be called while the Tx PDC is idle.
+ * 
+ * @param pdc_peripheral_base_address base memory address for the microprocessor UART specific PDC peripheral
+ * @param address address to the buffer in memory where the PDC will automatically retrieve outgoing bytes
+ * @param size the size of the transmission buffer, in bytes
+ * @param next_address address to the buffer the PDC will switch to once the current transfer completes
+ * @param next_size the size of the next transmission buffer, in bytes
+ * 
+ * @return void
+ */
+void HAL_PDC_TX_INIT_WITH_NEXT(pdc_t pdc_peripheral_base_address, uint32_t address, uint32_t size, uint32_t next_address, uint32_t next_size);
+
+#define HAL_PDC_MAX_TRANSFER_SIZE						(0xFFFF)		//the PDC counter registers are 16 bits wide
+
 #define HAL_PDC_ENABLE_TRANSMITTER_TRANSFER()			(this->pdc_peripheral_base_address->PERIPH_PTCR = PERIPH_PTCR_TXTEN)
 #define HAL_PDC_ENABLE_RECEIVER_TRANSFER()				(this->pdc_peripheral_base_address->PERIPH_PTCR = PERIPH_PTCR_RXTEN)
 #define HAL_PDC_DISABLE_TRANSMITTER_TRANSFER()			(this->pdc_peripheral_base_address->PERIPH_PTCR = PERIPH_PTCR_TXTDIS)
 #define HAL_PDC_DISABLE_RECEIVER_TRANSFER()				(this->pdc_peripheral_base_address->PERIPH_PTCR = PERIPH_PTCR_RXTDIS)
 #define HAL_PDC_READ_RECEIVE_COUNTER_VALUE()			(this->pdc_peripheral_base_address->PERIPH_RCR)
+#define HAL_PDC_READ_RECEIVE_POINTER_VALUE()			(this->pdc_peripheral_base_address->PERIPH_RPR)
+#define HAL_PDC_READ_RECEIVE_NEXT_COUNTER_VALUE()		(this->pdc_peripheral_base_address->PERIPH_RNCR)
+#define HAL_PDC_READ_TRANSMIT_POINTER_VALUE()			(this->pdc_peripheral_base_address->PERIPH_TPR)
+#define HAL_PDC_READ_TRANSMIT_COUNTER_VALUE()			(this->pdc_peripheral_base_address->PERIPH_TCR)
+#define HAL_PDC_READ_TRANSMIT_NEXT_POINTER_VALUE()		(this->pdc_peripheral_base_address->PERIPH_TNPR)
+#define HAL_PDC_READ_TRANSMIT_NEXT_COUNTER_VALUE()		(this->pdc_peripheral_base_address->PERIPH_TNCR)
+
+
+
+
+/**
+ * @brief Initializes a Timer Counter (TC) channel to generate a periodic interrupt
+ * 
+ * The channel is configured in waveform mode, counting up from zero to the RC compare value and resetting, with the
+ * RC compare interrupt enabled. The TC peripheral clock and the channel's NVIC interrupt are also enabled.
+ * The channel is clocked from TIMER_CLOCK1 (see HAL_TC_TIMER_CLOCK_FREQUENCY).
+ * 
+ * @param tc_peripheral_base_address base memory address for the microprocessor TC peripheral
+ * @param channel TC channel number within the peripheral (0 to TC_CHANNELS_PER_PORT - 1)
+ * @param period_in_timer_clocks number of timer clocks between interrupts
+ * 
+ * @return void
+ */
+void HAL_TC_INITIALIZE_PERIODIC_INTERRUPT(tc_t tc_peripheral_base_address, uint32_t channel, uint32_t period_in_timer_clocks);
+
+/**
+ * @brief Stops a Timer Counter (TC) channel and disables its interrupt
+ * 
+ * @param tc_peripheral_base_address base memory address for the microprocessor TC peripheral
+ * @param channel TC channel number within the peripheral (0 to TC_CHANNELS_PER_PORT - 1)
+ * 
+ * @return void
+ */
+void HAL_TC_STOP(tc_t tc_peripheral_base_address, uint32_t channel);
+
+/**
+ * @brief Restarts a Timer Counter (TC) channel stopped with HAL_TC_STOP, counting from zero
+ * 
+ * The channel keeps the period it was initialized with by HAL_TC_INITIALIZE_PERIODIC_INTERRUPT. Combined with
+ * HAL_TC_STOP in the interrupt handler, this gives a one-shot timer.
+ * 
+ * @param tc_peripheral_base_address base memory address for the microprocessor TC peripheral
+ * @param channel TC channel number within the peripheral (0 to TC_CHANNELS_PER_PORT - 1)
+ * 
+ * @return void
+ */
+void HAL_TC_RESTART(tc_t tc_peripheral_base_address, uint32_t channel);
+
+#define HAL_TC_TIMER_CLOCK_FREQUENCY					(SystemCoreClock/2)
+#define HAL_TC_IS_PERIOD_ELAPSED(tc, channel)			((tc)->TC_CHANNEL[(channel)].TC_SR & TC_SR_CPCS)
+
+//the DWT cycle counter is used to timestamp incoming bytes. It counts core clock cycles and must be enabled before it's read
+#define HAL_TIMESTAMP_ENABLE()							do { CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; } while(0)
+#define HAL_TIMESTAMP_READ()							(DWT->CYCCNT)
 
+#define HAL_ENTER_CRITICAL_SECTION(saved_state)			do { (saved_state) = __get_PRIMASK(); __disable_irq(); } while(0)
+#define HAL_EXIT_CRITICAL_SECTION(saved_state)			__set_PRIMASK(saved_state)
 
+/*exclusive load/store pair used for lock free updates. The store returns 0 if it succeeded, or non-zero if the location may have been modified 
+  since the load, in which case the update must be retried. On the Cortex-M4, any exception entry or return between the two also fails the store */
+#define HAL_LOAD_EXCLUSIVE(address)						__LDREXW(address)
+#define HAL_STORE_EXCLUSIVE(value, address)				__STREXW((value), (address))
+#define HAL_CLEAR_EXCLUSIVE()							__CLREX()
 
 
 
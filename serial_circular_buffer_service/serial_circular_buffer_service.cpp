@@ -15,6 +15,58 @@
 serial_circular_buffer *UART0_ISR_instance_ptr = NULL;
 serial_circular_buffer *UART1_ISR_instance_ptr = NULL;
 
+#pragma region Local Helper Functions
+/* returns the index of the first occurrence of delimiter in block, or block_size if it isn't present.
+   Once the block is word aligned, 4 bytes are tested at a time: XOR-ing with the delimiter replicated in every byte turns matching bytes into zero,
+   and (word - 0x01010101) & ~word & 0x80808080 sets the top bit of the lowest zero byte. Bits above the lowest zero byte can be false positives,
+   but they're never reached since the lowest set bit is the one used. */
+static uint32_t find_byte_in_block(const char *block, uint32_t block_size, uint8_t delimiter)
+{
+	const uint32_t	delimiter_pattern = 0x01010101UL * delimiter;
+	const uint32_t	*word_ptr;
+	uint32_t		word;
+	uint32_t		zero_byte_mask;
+	uint32_t		index = 0;
+	
+	//test one byte at a time until the block is word aligned
+	while((index < block_size) && (((uint32_t)&block[index] & 0x3) != 0))
+	{
+		if((uint8_t)block[index] == delimiter)
+		{
+			return(index);
+		}
+		index++;
+	}
+	
+	word_ptr = (const uint32_t *)&block[index];
+	
+	while((index + 4) <= block_size)
+	{
+		word = *word_ptr++ ^ delimiter_pattern;
+		zero_byte_mask = (word - 0x01010101UL) & ~word & 0x80808080UL;
+		
+		if(zero_byte_mask)
+		{
+			//the microprocessor is little endian, so the lowest set bit corresponds to the lowest address
+			return(index + (__builtin_ctz(zero_byte_mask) >> 3));
+		}
+		index += 4;
+	}
+	
+	//test the remaining bytes that don't fill a whole word
+	while(index < block_size)
+	{
+		if((uint8_t)block[index] == delimiter)
+		{
+			return(index);
+		}
+		index++;
+	}
+	
+	return(block_size);
+}
+#pragma endregion Local Helper Functions
+
 #pragma region Public Class Member Functions
 void serial_circular_buffer::init(uart_t uart_port_base_addr,
 								  char *Rx_buffer_ptr,
@@ -22,7 +74,8 @@ void serial_circular_buffer::init(uart_t uart_port_base_addr,
 								  char *Tx_buffer_ptr,
 								  uint32_t Tx_buffer_size_in_bytes,
 								  uint32_t baud_rate,
-								  uart_parity_selection_t parity)
+								  uart_parity_selection_t parity,
+								  rx_pdc_mode_t rx_pdc_mode)
 {	
 	this->uart_peripheral_base_address = uart_port_base_addr;
 	
@@ -40,16 +93,68 @@ void serial_circular_buffer::init(uart_t uart_port_base_addr,
 	HAL_UART_INITIAILZE(this->uart_peripheral_base_address, baud_rate, (uint32_t)parity);
 	
 	this->rx_buffer_size = Rx_buffer_size_in_bytes;
+	this->rx_buffer_wrap_mask = IS_POWER_OF_TWO(Rx_buffer_size_in_bytes) ? (Rx_buffer_size_in_bytes - 1) : 0;
 	this->rx_buffer = Rx_buffer_ptr;
 	this->tx_buffer_size = Tx_buffer_size_in_bytes;
+	this->tx_buffer_wrap_mask = IS_POWER_OF_TWO(Tx_buffer_size_in_bytes) ? (Tx_buffer_size_in_bytes - 1) : 0;
 	this->pdc_tx_buffer = Tx_buffer_ptr;
+	this->rx_pdc_mode = rx_pdc_mode;
+	this->baud_rate = baud_rate;
 	
 	this->rx_buffer_tail_index = 0;
+	this->rx_rollover_count = 0;
+	this->rx_bytes_consumed = 0;
+	this->rx_pdc_transfer_size = Rx_buffer_size_in_bytes;
+	this->rx_queued_transfer_index = 0;
+	this->rx_queued_transfer_size = Rx_buffer_size_in_bytes;
+	this->rx_watermark = 0;
+	this->rx_watermark_callback = NULL;
+	this->rx_watermark_callback_context = NULL;
+	this->idle_timer_base_address = NULL;
+	this->rx_idle_callback = NULL;
+	this->rx_timestamp_buffer = NULL;
+	this->contiguous_view_buffer = NULL;
+	this->contiguous_view_buffer_size = 0;
 	this->tx_buffer_head_index = 0;
+	this->tx_buffer_reserve_index = 0;
+	this->tx_number_of_producers = 0;
 	this->tx_buffer_tail_index = 0;
+	this->tx_buffer_release_index = 0;
+	this->tx_overflow_mode = TX_OVERFLOW_ALL_OR_NOTHING;
+	this->tx_blocking_timeout_in_cycles = 0;
+	this->tx_priority_buffer = NULL;
+	this->tx_priority_buffer_size = 0;
+	this->tx_priority_head_index = 0;
+	this->tx_priority_tail_index = 0;
+	this->tx_priority_release_index = 0;
+	this->tx_bulk_chunk_size = HAL_PDC_MAX_TRANSFER_SIZE;
+	this->tx_complete_callback = NULL;
+	this->tx_complete_callback_context = NULL;
+	this->tx_coalescing_timer_base_address = NULL;
+	this->tx_coalescing_timer_armed = false;
+	this->tx_pacing_timer_base_address = NULL;
+	this->tx_pacing_waiting = false;
+	this->tx_urgent_in_flight = false;
+	this->tx_interrupted_size = 0;
+	this->tx_interrupted_next_size = 0;
+	this->tx_descriptor_queue = NULL;
+	this->tx_descriptor_queue_size = 0;
+	this->tx_descriptor_head_index = 0;
+	this->tx_descriptor_tail_index = 0;
+	this->tx_descriptor_offset = 0;
+	this->tx_descriptor_in_flight = false;
 	this->pdc_Tx_in_progress = false;
 	
-	HAL_PDC_RX_INIT_NO_NEXT(this->pdc_peripheral_base_address, (uint32_t)this->rx_buffer, this->rx_buffer_size);
+	if(this->rx_pdc_mode == RX_PDC_MODE_WITH_NEXT)
+	{
+		HAL_PDC_RX_INIT_WITH_NEXT(this->pdc_peripheral_base_address, (uint32_t)this->rx_buffer, this->rx_buffer_size, (uint32_t)this->rx_buffer, this->rx_buffer_size);
+		HAL_UART_ENABLE_END_OF_RX_TRANSFER_INTERRUPT();
+	}
+	else
+	{
+		HAL_PDC_RX_INIT_NO_NEXT(this->pdc_peripheral_base_address, (uint32_t)this->rx_buffer, this->rx_buffer_size);
+		HAL_UART_DISABLE_END_OF_RX_TRANSFER_INTERRUPT();
+	}
 	
 	HAL_PDC_ENABLE_TRANSMITTER_TRANSFER();
 	HAL_PDC_ENABLE_RECEIVER_TRANSFER();
@@ -95,142 +200,1494 @@ uint32_t serial_circular_buffer::get_number_of_unread_bytes(void)
 	return((uint32_t)difference);
 }
 
-void serial_circular_buffer::copy_packet_into_Tx_buffer_and_transmit(char* serialized_data_to_transmit, uint32_t number_of_bytes_to_transmit)
+uint32_t serial_circular_buffer::read_bytes(char* destination_buffer, uint32_t max_number_of_bytes)
+{
+	uint32_t number_of_bytes_read = 0;
+	
+	number_of_bytes_read = this->peek_copy(0, destination_buffer, max_number_of_bytes);
+	
+	//the tail index is only updated once, after the copy completes
+	this->increment_rx_buffer_tail_index(number_of_bytes_read);
+	
+	return(number_of_bytes_read);
+}
+
+char serial_circular_buffer::peek_at(uint32_t offset)
+{
+	uint32_t index = 0;
+	
+	index = this->rx_buffer_tail_index + offset;
+	
+	//offset is less than the buffer size, so a single subtraction handles the roll over
+	if(index >= this->rx_buffer_size)
+	{
+		index -= this->rx_buffer_size;
+	}
+	
+	return(this->rx_buffer[index]);
+}
+
+uint32_t serial_circular_buffer::peek_copy(uint32_t offset, char* destination_buffer, uint32_t number_of_bytes)
+{
+	rx_buffer_spans_t spans;
+	uint32_t number_of_unread_bytes = 0;
+	uint32_t first_block_bytes_to_copy = 0;
+	
+	number_of_unread_bytes = this->peek_spans(&spans);
+	
+	if(offset >= number_of_unread_bytes)
+	{
+		return(0);
+	}
+	
+	if(number_of_bytes > (number_of_unread_bytes - offset))
+	{
+		number_of_bytes = number_of_unread_bytes - offset;
+	}
+	
+	//copy whatever part of the requested bytes lies in the first contiguous block
+	if(offset < spans.first_block_size)
+	{
+		first_block_bytes_to_copy = spans.first_block_size - offset;
+		
+		if(first_block_bytes_to_copy > number_of_bytes)
+		{
+			first_block_bytes_to_copy = number_of_bytes;
+		}
+		
+		memcpy(destination_buffer, &(spans.first_block_ptr[offset]), first_block_bytes_to_copy);
+		offset += first_block_bytes_to_copy;
+	}
+	
+	//if applicable, copy the remaining bytes from the beginning of the circular buffer
+	if(number_of_bytes > first_block_bytes_to_copy)
+	{
+		memcpy(&(destination_buffer[first_block_bytes_to_copy]), &(spans.second_block_ptr[offset - spans.first_block_size]), number_of_bytes - first_block_bytes_to_copy);
+	}
+	
+	return(number_of_bytes);
+}
+
+void serial_circular_buffer::set_contiguous_view_buffer(char *scratch_buffer, uint32_t scratch_buffer_size)
+{
+	this->contiguous_view_buffer = scratch_buffer;
+	this->contiguous_view_buffer_size = scratch_buffer_size;
+}
+
+const char* serial_circular_buffer::contiguous_view(uint32_t number_of_bytes)
+{
+	rx_buffer_spans_t spans;
+	
+	if(this->peek_spans(&spans) < number_of_bytes)
+	{
+		return(NULL);
+	}
+	
+	//in the usual case, the requested bytes are already contiguous in the Rx buffer
+	if(number_of_bytes <= spans.first_block_size)
+	{
+		return(spans.first_block_ptr);
+	}
+	
+	//if here, the requested bytes wrap around the end of the Rx buffer and need to be copied into the scratch buffer
+	if((this->contiguous_view_buffer == NULL) || (number_of_bytes > this->contiguous_view_buffer_size))
+	{
+		return(NULL);
+	}
+	
+	memcpy(this->contiguous_view_buffer, spans.first_block_ptr, spans.first_block_size);
+	memcpy(&(this->contiguous_view_buffer[spans.first_block_size]), spans.second_block_ptr, number_of_bytes - spans.first_block_size);
+	
+	return(this->contiguous_view_buffer);
+}
+
+uint32_t serial_circular_buffer::peek_spans(rx_buffer_spans_t *spans)
 {
-	uint32_t first_contiguous_block_size = 0;
-	uint32_t second_contiguous_block_size = 0;
-	uint32_t initial_tx_buffer_head_index = 0;
-	uint8_t circular_buffer_rollover_condition = 0;
+	uint32_t number_of_unread_bytes = 0;
+	uint32_t tail_index = 0;
+	
+	number_of_unread_bytes = this->get_number_of_unread_bytes();
+	tail_index = this->rx_buffer_tail_index;
 	
-	initial_tx_buffer_head_index = this->tx_buffer_head_index;	//save off the original circular buffer head index value for later use in this function
+	spans->first_block_ptr = &(this->rx_buffer[tail_index]);
+	spans->second_block_ptr = this->rx_buffer;
 	
-	//first, determine if the packet we're transmitting needs to be divided up between the end and the beginning of the circular buffer and handle it
-	if((number_of_bytes_to_transmit + this->tx_buffer_head_index) > this->tx_buffer_size)
+	//determine if the unread bytes are divided up between the end and the beginning of the circular buffer
+	if((tail_index + number_of_unread_bytes) > this->rx_buffer_size)
 	{
-		circular_buffer_rollover_condition = 1;
-		first_contiguous_block_size = this->tx_buffer_size - this->tx_buffer_head_index;
-		second_contiguous_block_size = (number_of_bytes_to_transmit + this->tx_buffer_head_index) - this->tx_buffer_size;		
+		spans->first_block_size = this->rx_buffer_size - tail_index;
+		spans->second_block_size = number_of_unread_bytes - spans->first_block_size;
 	}
 	else
 	{
-        first_contiguous_block_size = number_of_bytes_to_transmit;
+		spans->first_block_size = number_of_unread_bytes;
+		spans->second_block_size = 0;
 	}
+	
+	return(number_of_unread_bytes);
+}
 
-	//copy the first contiguous block of packet bytes from the circular buffer to the PDC Tx buffer
-	memcpy(&(this->pdc_tx_buffer[this->tx_buffer_head_index]), serialized_data_to_transmit, first_contiguous_block_size);
-	this->increment_tx_buffer_head_index(first_contiguous_block_size);
+uint32_t serial_circular_buffer::consume(uint32_t number_of_bytes)
+{
+	uint32_t number_of_unread_bytes = 0;
+	
+	number_of_unread_bytes = this->get_number_of_unread_bytes();
 	
-	//if applicable, copy the remaining packet bytes to the beginning of the circular buffer
-	if(circular_buffer_rollover_condition)
+	if(number_of_bytes > number_of_unread_bytes)
 	{
-		memcpy(&(this->pdc_tx_buffer[this->tx_buffer_head_index]), &(serialized_data_to_transmit[first_contiguous_block_size]), second_contiguous_block_size);
-		this->increment_tx_buffer_head_index(second_contiguous_block_size);
+		number_of_bytes = number_of_unread_bytes;
 	}
+	
+	this->increment_rx_buffer_tail_index(number_of_bytes);
+	
+	return(number_of_bytes);
+}
+
+uint32_t serial_circular_buffer::skip(uint32_t number_of_bytes)
+{
+	//releasing bytes processed in place and discarding unwanted bytes both come down to moving the tail index
+	return(this->consume(number_of_bytes));
+}
 
-	//only initiate a new transmit if the PDC not currently transmitting any data. This allows multiple application threads to queue up outgoing data in the buffer
-	if(this->pdc_Tx_in_progress == false)
+uint32_t serial_circular_buffer::flush_rx(void)
+{
+	uint64_t number_of_discarded_bytes = 0;
+	
+	number_of_discarded_bytes = this->resync_rx();
+	
+	//only a full buffer's worth of bytes can have been unread, anything beyond that was already lost to an overrun
+	if(number_of_discarded_bytes > this->rx_buffer_size)
 	{
-		this->pdc_Tx_in_progress = true;
-		
-		//"pre-load" tail so when ISR fires, it will see we've already transmitted the "first_block_size" amount of bytes
-		this->increment_tx_buffer_tail_index(first_contiguous_block_size);			
-		this->initiate_PDC_Tx(&(this->pdc_tx_buffer[initial_tx_buffer_head_index]), first_contiguous_block_size);
+		number_of_discarded_bytes = this->rx_buffer_size;
+	}
+	
+	return((uint32_t)number_of_discarded_bytes);
+}
+
+uint32_t serial_circular_buffer::find_byte(uint8_t delimiter, uint32_t start_offset)
+{
+	rx_buffer_spans_t spans;
+	uint32_t number_of_unread_bytes = 0;
+	uint32_t index = 0;
+	
+	number_of_unread_bytes = this->peek_spans(&spans);
+	
+	if(start_offset >= number_of_unread_bytes)
+	{
+		return(RX_BYTE_NOT_FOUND);
+	}
+	
+	//search whatever part of the first contiguous block lies at or after start_offset
+	if(start_offset < spans.first_block_size)
+	{
+		index = find_byte_in_block(&(spans.first_block_ptr[start_offset]), spans.first_block_size - start_offset, delimiter);
 		
-		/*if we've determined earlier in this function that a roll over condition exists, the PDC tx ISR will see bytes are still sitting in the circular 
-		 buffer needing transmitted and call initiate_PDC_Tx() again to send those bytes out */
+		if(index < (spans.first_block_size - start_offset))
+		{
+			return(start_offset + index);
+		}
+		start_offset = spans.first_block_size;
+	}
+	
+	//if applicable, continue the search from the beginning of the circular buffer
+	index = find_byte_in_block(&(spans.second_block_ptr[start_offset - spans.first_block_size]), number_of_unread_bytes - start_offset, delimiter);
+	
+	if(index < (number_of_unread_bytes - start_offset))
+	{
+		return(start_offset + index);
 	}
 	
+	return(RX_BYTE_NOT_FOUND);
 }
-#pragma endregion Public Class Member Functions
 
-#pragma region Private Class Member Functions
-uint32_t serial_circular_buffer::get_rx_buffer_head_index(void)
+uint32_t serial_circular_buffer::read_until(uint8_t delimiter, char* destination_buffer, uint32_t destination_buffer_size)
 {
-	return(this->rx_buffer_size - HAL_PDC_READ_RECEIVE_COUNTER_VALUE());
+	uint32_t delimiter_offset = 0;
+	
+	delimiter_offset = this->find_byte(delimiter);
+	
+	//a frame is only returned once it's complete and fits in the destination buffer, delimiter included
+	if((delimiter_offset == RX_BYTE_NOT_FOUND) || (delimiter_offset >= destination_buffer_size))
+	{
+		return(0);
+	}
+	
+	return(this->read_bytes(destination_buffer, delimiter_offset + 1));
 }
 
-void serial_circular_buffer::increment_rx_buffer_tail_index(uint32_t increment_index)
+uint64_t serial_circular_buffer::get_total_number_of_received_bytes(void)
 {
-	this->rx_buffer_tail_index = (this->rx_buffer_tail_index + increment_index) % this->rx_buffer_size;
+	uint32_t head_index;
+	
+	return(this->get_rx_snapshot(&head_index));
 }
 
-void serial_circular_buffer::increment_tx_buffer_head_index(uint32_t increment_index)
+uint64_t serial_circular_buffer::get_total_number_of_consumed_bytes(void)
 {
-	this->tx_buffer_head_index = (this->tx_buffer_head_index + increment_index) % this->tx_buffer_size;
+	return(this->rx_bytes_consumed);
 }
 
-void serial_circular_buffer::increment_tx_buffer_tail_index( uint32_t increment_index)
+bool serial_circular_buffer::rx_overrun(void)
 {
-	this->tx_buffer_tail_index = (this->tx_buffer_tail_index + increment_index) % this->tx_buffer_size;
+	//once a full buffer's worth of bytes is outstanding, the head index has caught up with the tail index and the unread byte count is no longer valid
+	return((this->get_total_number_of_received_bytes() - this->rx_bytes_consumed) >= this->rx_buffer_size);
 }
 
-uint32_t serial_circular_buffer::get_number_of_unsent_bytes()
+uint32_t serial_circular_buffer::get_number_of_lost_rx_bytes(void)
 {
-	int32_t difference = 0;
+	uint64_t outstanding_bytes = 0;
 	
-	difference = this->tx_buffer_head_index - this->tx_buffer_tail_index;
+	outstanding_bytes = this->get_total_number_of_received_bytes() - this->rx_bytes_consumed;
 	
-	//the following conditional check handles the scenario where the head index has rolled back over to beginning of buffer	
-	if(difference < 0)
+	if(outstanding_bytes <= this->rx_buffer_size)
 	{
-		difference += this->tx_buffer_size;
+		return(0);
 	}
 	
-	return((uint32_t)difference);
+	return((uint32_t)(outstanding_bytes - this->rx_buffer_size));
 }
 
-void serial_circular_buffer::initiate_PDC_Tx(char *pointer_to_Tx_buffer, uint32_t bytes_to_transfer)
+uint64_t serial_circular_buffer::resync_rx(void)
 {
-	HAL_PDC_TX_INIT_NO_NEXT(this->pdc_peripheral_base_address, (uint32_t)(pointer_to_Tx_buffer), bytes_to_transfer);	
-	HAL_UART_ENABLE_TX_BUFFER_EMPTY_INTERRUPT();
+	uint64_t total_number_of_received_bytes = 0;
+	uint64_t number_of_discarded_bytes = 0;
+	uint32_t head_index = 0;
+	
+	total_number_of_received_bytes = this->get_rx_snapshot(&head_index);
+	number_of_discarded_bytes = total_number_of_received_bytes - this->rx_bytes_consumed;
+	
+	this->rx_buffer_tail_index = this->wrap_rx_index(head_index);
+	this->rx_bytes_consumed = total_number_of_received_bytes;
+	
+	return(number_of_discarded_bytes);
+}
 
+void serial_circular_buffer::set_rx_watermark(uint32_t watermark_in_bytes, serial_circular_buffer_callback_t callback, void *callback_context, uint32_t check_interval_in_bytes)
+{
+	if((watermark_in_bytes == 0) || (callback == NULL))
+	{
+		//watermark disabled, so go back to a single transfer for the whole buffer
+		this->rx_watermark_callback = NULL;
+		this->rx_pdc_transfer_size = this->rx_buffer_size;
+		return;
+	}
+	
+	if(check_interval_in_bytes == 0)
+	{
+		check_interval_in_bytes = watermark_in_bytes;
+	}
+	
+	if(check_interval_in_bytes > this->rx_buffer_size)
+	{
+		check_interval_in_bytes = this->rx_buffer_size;
+	}
+	
+	//the callback is cleared first, so the ISR never sees a new callback paired with the old context
+	this->rx_watermark_callback = NULL;
+	this->rx_watermark = watermark_in_bytes;
+	this->rx_watermark_callback_context = callback_context;
+	this->rx_pdc_transfer_size = check_interval_in_bytes;
+	this->rx_watermark_callback = callback;
 }
-#pragma endregion Private Class Member Functions
 
-#pragma region UART ISR Handlers
-void UART0_Handler(void)
+void serial_circular_buffer::enable_rx_idle_detection(tc_t tc_port_base_addr, uint32_t tc_channel, uint32_t idle_time_in_bit_times, serial_circular_buffer_callback_t callback, void *callback_context)
 {
-	UART0_ISR_instance_ptr->serial_circular_buffer_irq_handler();
+	uint32_t period_in_timer_clocks = 0;
+	
+	this->disable_rx_idle_detection();
+	
+	this->idle_timer_base_address = tc_port_base_addr;
+	this->idle_timer_channel = tc_channel;
+	this->rx_idle_callback = callback;
+	this->rx_idle_callback_context = callback_context;
+	this->rx_idle_last_number_of_received_bytes = this->get_total_number_of_received_bytes();
+	this->rx_activity_since_idle = false;
+	
+	period_in_timer_clocks = (uint32_t)(((uint64_t)HAL_TC_TIMER_CLOCK_FREQUENCY * idle_time_in_bit_times) / this->baud_rate);
+	
+	HAL_TC_INITIALIZE_PERIODIC_INTERRUPT(this->idle_timer_base_address, this->idle_timer_channel, period_in_timer_clocks);
 }
 
-void UART1_Handler(void)
+void serial_circular_buffer::disable_rx_idle_detection(void)
 {
-	UART1_ISR_instance_ptr->serial_circular_buffer_irq_handler();
+	if(this->idle_timer_base_address != NULL)
+	{
+		HAL_TC_STOP(this->idle_timer_base_address, this->idle_timer_channel);
+		this->idle_timer_base_address = NULL;
+	}
 }
 
-void serial_circular_buffer::serial_circular_buffer_irq_handler(void)
+void serial_circular_buffer::enable_rx_timestamps(rx_timestamp_t *timestamp_buffer, uint32_t number_of_timestamps)
 {
-	uint32_t	number_of_unsent_tx_bytes;
-	uint32_t	number_of_bytes_to_send;
+	HAL_TIMESTAMP_ENABLE();
+	
+	//the buffer is cleared first, so the ISR never records into a half configured buffer
+	this->rx_timestamp_buffer = NULL;
+	this->rx_timestamp_buffer_size = number_of_timestamps;
+	this->rx_timestamp_head_index = 0;
+	this->rx_timestamp_tail_index = 0;
+	this->rx_last_timestamped_number_of_received_bytes = (uint32_t)this->get_total_number_of_received_bytes();
+	this->rx_timestamp_buffer = timestamp_buffer;
+}
 
-	if(HAL_UART_IS_RECEIVE_BUFFER_FULL())
+bool serial_circular_buffer::get_rx_arrival_time(uint32_t *timestamp)
+{
+	uint32_t number_of_consumed_bytes = 0;
+	
+	if(this->rx_timestamp_buffer == NULL)
 	{
-		//if here, the rx circular buffer needs to roll over. Re-initialize the PDC with the address of the first element of the Rx circular buffer
-		HAL_PDC_RX_INIT_NO_NEXT(this->pdc_peripheral_base_address, (uint32_t)this->rx_buffer, this->rx_buffer_size);
+		return(false);
+	}
+	
+	number_of_consumed_bytes = (uint32_t)this->rx_bytes_consumed;
+	
+	//release every timestamp taken before the oldest unread byte arrived. The byte counts are compared as a signed difference, so they're allowed to wrap
+	while((this->rx_timestamp_tail_index != this->rx_timestamp_head_index) &&
+		  ((int32_t)(this->rx_timestamp_buffer[this->rx_timestamp_tail_index].number_of_received_bytes - number_of_consumed_bytes) <= 0))
+	{
+		this->rx_timestamp_tail_index = (this->rx_timestamp_tail_index + 1) % this->rx_timestamp_buffer_size;
+	}
+	
+	if(this->rx_timestamp_tail_index == this->rx_timestamp_head_index)
+	{
+		return(false);
+	}
+	
+	*timestamp = this->rx_timestamp_buffer[this->rx_timestamp_tail_index].timestamp;
+	
+	return(true);
+}
+
+uint32_t serial_circular_buffer::copy_packet_into_Tx_buffer_and_transmit(char* serialized_data_to_transmit, uint32_t number_of_bytes_to_transmit)
+{
+	tx_buffer_spans_t spans;
+	uint32_t start_index = 0;
+	
+	//wait before registering as a producer, since the bytes other threads are writing can't be transmitted to free up space while we're registered
+	this->wait_for_tx_buffer_free_space(number_of_bytes_to_transmit);
+	
+	this->register_tx_producer();
+	
+	//never overwrite bytes that haven't been transmitted yet
+	number_of_bytes_to_transmit = this->claim_tx_buffer_space(number_of_bytes_to_transmit, (this->tx_overflow_mode == TX_OVERFLOW_ACCEPT_PARTIAL), &start_index);
+	
+	if(number_of_bytes_to_transmit != 0)
+	{
+		//determine if the packet we're transmitting needs to be divided up between the end and the beginning of the circular buffer
+		this->get_tx_buffer_spans(start_index, number_of_bytes_to_transmit, &spans);
+		this->write_tx_buffer_spans(&spans, 0, serialized_data_to_transmit, number_of_bytes_to_transmit);
+	}
+	
+	this->release_tx_producer();
+	
+	return(number_of_bytes_to_transmit);
+}
+
+uint32_t serial_circular_buffer::transmit_vectored(const comms_packet_fragment_t* fragments, uint32_t number_of_fragments)
+{
+	tx_buffer_spans_t spans;
+	uint32_t number_of_bytes_to_transmit = 0;
+	uint32_t offset = 0;
+	uint32_t i = 0;
+	
+	for(i = 0; i < number_of_fragments; i++)
+	{
+		number_of_bytes_to_transmit += fragments[i].size;
+	}
+	
+	if(this->reserve_tx(number_of_bytes_to_transmit, &spans) == 0)
+	{
+		return(0);
 	}
+	
+	for(i = 0; i < number_of_fragments; i++)
+	{
+		this->write_tx_buffer_spans(&spans, offset, fragments[i].data, fragments[i].size);
+		offset += fragments[i].size;
+	}
+	
+	//the head index is only updated, and the PDC only started, once the whole packet is in the buffer
+	this->commit_tx(&spans, number_of_bytes_to_transmit);
+	
+	return(number_of_bytes_to_transmit);
+}
 
-	if(HAL_UART_IS_TRANSMIT_BUFFER_EMPTY())
+uint32_t serial_circular_buffer::reserve_tx(uint32_t number_of_bytes, tx_buffer_spans_t *spans)
+{
+	uint32_t start_index = 0;
+	
+	if((number_of_bytes == 0) || (this->wait_for_tx_buffer_free_space(number_of_bytes) < number_of_bytes))
 	{
-		number_of_unsent_tx_bytes = this->get_number_of_unsent_bytes();
+		return(0);
+	}
+	
+	this->register_tx_producer();
+	
+	//another thread may have taken the free space in the meantime
+	if(this->claim_tx_buffer_space(number_of_bytes, false, &start_index) == 0)
+	{
+		this->release_tx_producer();
+		return(0);
+	}
+	
+	this->get_tx_buffer_spans(start_index, number_of_bytes, spans);
+	
+	return(number_of_bytes);
+}
 
-		if(number_of_unsent_tx_bytes)
+bool serial_circular_buffer::commit_tx(const tx_buffer_spans_t *spans, uint32_t number_of_bytes)
+{
+	uint32_t number_of_reserved_bytes = spans->first_block_size + spans->second_block_size;
+	uint32_t start_index = (uint32_t)(spans->first_block_ptr - this->pdc_tx_buffer);
+	uint32_t end_index = this->wrap_tx_index(start_index + number_of_reserved_bytes);
+	
+	if(number_of_bytes > number_of_reserved_bytes)
+	{
+		return(false);
+	}
+	
+	if(number_of_bytes < number_of_reserved_bytes)
+	{
+		/*the unused end of the reservation can only be handed back while no other thread has reserved space after it. Otherwise the reservation 
+		  is left as it is, and has to be committed in full */
+		do
 		{
-			if(this->tx_buffer_head_index < this->tx_buffer_tail_index)						//check for rollover (i.e. bytes to send at the end of the buffer, and the beginning)
-			{
-				number_of_bytes_to_send = this->tx_buffer_size - tx_buffer_tail_index;		//if packet is split up between end and beginning of buffer,
-			}																				//send contiguous end of buffer 1st. ISR will then fire again, to send remainder at beginning of buffer.
-			else
+			if(HAL_LOAD_EXCLUSIVE(&(this->tx_buffer_reserve_index)) != end_index)
 			{
-				number_of_bytes_to_send = number_of_unsent_tx_bytes;
+				HAL_CLEAR_EXCLUSIVE();
+				return(false);
 			}
-			this->initiate_PDC_Tx(&(this->pdc_tx_buffer[this->tx_buffer_tail_index]), number_of_bytes_to_send);
-			this->increment_tx_buffer_tail_index(number_of_bytes_to_send);			
-			this->pdc_Tx_in_progress = true;
+		} while(HAL_STORE_EXCLUSIVE(this->wrap_tx_index(start_index + number_of_bytes), &(this->tx_buffer_reserve_index)));
+	}
+	
+	//the reserved space is already accounted for, so all that's left is to make it visible to the ISR
+	this->release_tx_producer();
+	
+	return(true);
+}
+
+void serial_circular_buffer::enable_tx_descriptor_queue(tx_descriptor_t *descriptor_buffer, uint32_t number_of_descriptors)
+{
+	uint32_t i = 0;
+	
+	for(i = 0; i < number_of_descriptors; i++)
+	{
+		descriptor_buffer[i].ready = false;
+	}
+	
+	this->tx_descriptor_queue_size = number_of_descriptors;
+	this->tx_descriptor_head_index = 0;
+	this->tx_descriptor_tail_index = 0;
+	this->tx_descriptor_offset = 0;
+	this->tx_descriptor_queue = descriptor_buffer;
+}
+
+bool serial_circular_buffer::enqueue_tx_descriptor(const char *data, uint32_t number_of_bytes, serial_circular_buffer_callback_t callback, void *callback_context)
+{
+	tx_descriptor_t *descriptor;
+	uint32_t head_index = 0;
+	uint32_t next_head_index = 0;
+	uint32_t tx_buffer_position = 0;
+	
+	if((this->tx_descriptor_queue == NULL) || (number_of_bytes == 0))
+	{
+		return(false);
+	}
+	
+	//registering as a producer holds the head index back, so the ISR can't get past the descriptor's position before it's been filled in
+	this->register_tx_producer();
+	
+	/*the descriptor is claimed and its position recorded in one exclusive load/store, so no other thread can reserve Tx buffer space in between,
+	  and the descriptors are always queued in the same order as their positions */
+	do
+	{
+		head_index = HAL_LOAD_EXCLUSIVE(&(this->tx_descriptor_head_index));
+		next_head_index = (head_index + 1) % this->tx_descriptor_queue_size;
+		
+		if(next_head_index == this->tx_descriptor_tail_index)
+		{
+			HAL_CLEAR_EXCLUSIVE();
+			this->release_tx_producer();
+			return(false);
 		}
-		else
-		{		
-			this->pdc_Tx_in_progress = false;
-			HAL_UART_DISABLE_TX_BUFFER_EMPTY_INTERRUPT();
+		
+		tx_buffer_position = this->tx_buffer_reserve_index;
+		
+	} while(HAL_STORE_EXCLUSIVE(next_head_index, &(this->tx_descriptor_head_index)));
+	
+	descriptor = &(this->tx_descriptor_queue[head_index]);
+	descriptor->data = data;
+	descriptor->size = number_of_bytes;
+	descriptor->callback = callback;
+	descriptor->callback_context = callback_context;
+	descriptor->tx_buffer_position = tx_buffer_position;
+	
+	//the descriptor is only acted on by the ISR once it's completely filled in
+	descriptor->ready = true;
+	
+	this->release_tx_producer();
+	
+	return(true);
+}
+
+bool serial_circular_buffer::transmit_constant_frame(const tx_constant_frame_t *frame)
+{
+	//the frame never changes, so there's nothing to be notified about once it has been sent
+	return(this->enqueue_tx_descriptor(frame->data, frame->size, NULL));
+}
+
+bool serial_circular_buffer::abort_and_transmit_urgent(const char *frame_data, uint32_t number_of_bytes)
+{
+	uint32_t interrupt_state = 0;
+	
+	if((number_of_bytes == 0) || (number_of_bytes > HAL_PDC_MAX_TRANSFER_SIZE))
+	{
+		return(false);
+	}
+	
+	//the transmitter's state has to be examined and taken over in one go, so neither the UART nor a TC interrupt can act on it in between
+	HAL_ENTER_CRITICAL_SECTION(interrupt_state);
+	
+	if(this->tx_urgent_in_flight)
+	{
+		HAL_EXIT_CRITICAL_SECTION(interrupt_state);
+		return(false);
+	}
+	
+	this->tx_interrupted_size = 0;
+	this->tx_interrupted_next_size = 0;
+	
+	if(HAL_UART_IS_TX_BUFFER_EMPTY_INTERRUPT_ENABLED())
+	{
+		//the PDC has been started, and whoever started it is done with it. Stop it at the next byte boundary and save whatever it has left to send
+		HAL_PDC_DISABLE_TRANSMITTER_TRANSFER();
+		
+		this->tx_interrupted_pointer = (char *)HAL_PDC_READ_TRANSMIT_POINTER_VALUE();
+		this->tx_interrupted_size = HAL_PDC_READ_TRANSMIT_COUNTER_VALUE();
+		this->tx_interrupted_next_pointer = (char *)HAL_PDC_READ_TRANSMIT_NEXT_POINTER_VALUE();
+		this->tx_interrupted_next_size = HAL_PDC_READ_TRANSMIT_NEXT_COUNTER_VALUE();
+	}
+	else if(this->tx_pacing_waiting)
+	{
+		//the PDC is idle until the next pacing period. The urgent frame takes over, and the ISR carries on with the paced bytes once it has been sent
+		this->tx_pacing_waiting = false;
+	}
+	else if(this->pdc_Tx_in_progress)
+	{
+		//a thread or interrupt has claimed the transmitter, but hasn't started the PDC yet. It would overwrite the urgent frame's transfer
+		HAL_EXIT_CRITICAL_SECTION(interrupt_state);
+		return(false);
+	}
+	
+	this->pdc_Tx_in_progress = true;
+	this->tx_urgent_in_flight = true;
+	
+	//the next pointer is cleared as well, so the PDC doesn't carry on into the rest of the interrupted transfer by itself
+	HAL_PDC_TX_INIT_WITH_NEXT(this->pdc_peripheral_base_address, (uint32_t)frame_data, number_of_bytes, 0, 0);
+	HAL_UART_ENABLE_TX_BUFFER_EMPTY_INTERRUPT();
+	
+	HAL_EXIT_CRITICAL_SECTION(interrupt_state);
+	
+	return(true);
+}
+
+void serial_circular_buffer::enable_tx_priority_lane(char *priority_buffer, uint32_t priority_buffer_size, uint32_t bulk_chunk_size)
+{
+	this->tx_priority_buffer_size = priority_buffer_size;
+	this->tx_priority_head_index = 0;
+	this->tx_priority_tail_index = 0;
+	this->tx_priority_release_index = 0;
+	this->tx_priority_buffer = priority_buffer;
+	
+	if((bulk_chunk_size == 0) || (bulk_chunk_size > HAL_PDC_MAX_TRANSFER_SIZE))
+	{
+		bulk_chunk_size = HAL_PDC_MAX_TRANSFER_SIZE;
+	}
+	this->tx_bulk_chunk_size = bulk_chunk_size;
+}
+
+uint32_t serial_circular_buffer::copy_packet_into_priority_Tx_buffer_and_transmit(const char* serialized_data_to_transmit, uint32_t number_of_bytes_to_transmit)
+{
+	tx_buffer_spans_t spans;
+	int32_t free_space = 0;
+	uint32_t next_head_index = 0;
+	
+	if((this->tx_priority_buffer == NULL) || (number_of_bytes_to_transmit == 0))
+	{
+		return(0);
+	}
+	
+	//same calculation as get_tx_buffer_free_space(). There's only one producer, so the head index doubles as the reserve index
+	free_space = this->tx_priority_release_index - this->tx_priority_head_index;
+	
+	if(free_space <= 0)
+	{
+		free_space += this->tx_priority_buffer_size;
+	}
+	
+	if(number_of_bytes_to_transmit > (uint32_t)(free_space - 1))
+	{
+		return(0);
+	}
+	
+	//the packet may need to be divided up between the end and the beginning of the priority buffer
+	spans.first_block_ptr = &(this->tx_priority_buffer[this->tx_priority_head_index]);
+	spans.first_block_size = this->tx_priority_buffer_size - this->tx_priority_head_index;
+	spans.second_block_ptr = this->tx_priority_buffer;
+	
+	if(spans.first_block_size > number_of_bytes_to_transmit)
+	{
+		spans.first_block_size = number_of_bytes_to_transmit;
+	}
+	spans.second_block_size = number_of_bytes_to_transmit - spans.first_block_size;
+	
+	this->write_tx_buffer_spans(&spans, 0, serialized_data_to_transmit, number_of_bytes_to_transmit);
+	
+	//the packet is only made visible to the ISR once it's completely in the buffer
+	next_head_index = this->tx_priority_head_index + number_of_bytes_to_transmit;
+	if(next_head_index >= this->tx_priority_buffer_size)
+	{
+		//the packet is never bigger than the free space, so the head can only wrap once
+		next_head_index -= this->tx_priority_buffer_size;
+	}
+	this->tx_priority_head_index = next_head_index;
+	
+	this->start_tx_if_idle(false);
+	
+	return(number_of_bytes_to_transmit);
+}
+
+uint32_t serial_circular_buffer::get_tx_buffer_free_space(void)
+{
+	int32_t difference = 0;
+	
+	//everything from the release index up to the reserve index is either being written, waiting to be transmitted or being transmitted
+	difference = this->tx_buffer_release_index - this->tx_buffer_reserve_index;
+	
+	//the following conditional check handles the scenario where the head index has rolled back over to beginning of buffer
+	if(difference <= 0)
+	{
+		difference += this->tx_buffer_size;
+	}
+	
+	//one byte is always left free, so a full buffer can be told apart from an empty one
+	return((uint32_t)(difference - 1));
+}
+
+bool serial_circular_buffer::flush(uint32_t timeout_in_us)
+{
+	uint32_t start_time = 0;
+	uint32_t timeout_in_cycles = 0;
+	
+	HAL_TIMESTAMP_ENABLE();
+	
+	start_time = HAL_TIMESTAMP_READ();
+	timeout_in_cycles = timeout_in_us * (SystemCoreClock / 1000000);
+	
+	//don't wait for the coalescing deadline to send bytes that are being held back
+	this->start_tx_if_idle(false);
+	
+	//TXEMPTY is also set while nothing has been transmitted yet, so the PDC must have finished with every queued byte as well
+	while(this->pdc_Tx_in_progress || this->is_tx_data_queued() || !HAL_UART_IS_TRANSMITTER_EMPTY())
+	{
+		if((HAL_TIMESTAMP_READ() - start_time) >= timeout_in_cycles)
+		{
+			return(false);
+		}
+	}
+	
+	return(true);
+}
+
+void serial_circular_buffer::set_tx_complete_callback(serial_circular_buffer_callback_t callback, void *callback_context)
+{
+	HAL_UART_DISABLE_TX_EMPTY_INTERRUPT();
+	
+	this->tx_complete_callback_context = callback_context;
+	this->tx_complete_callback = callback;
+}
+
+void serial_circular_buffer::enable_tx_coalescing(tc_t tc_port_base_addr, uint32_t tc_channel, uint32_t threshold_in_bytes, uint32_t deadline_in_us)
+{
+	uint32_t period_in_timer_clocks = 0;
+	
+	this->disable_tx_coalescing();
+	
+	this->tx_coalescing_timer_channel = tc_channel;
+	this->tx_coalescing_threshold = threshold_in_bytes;
+	
+	period_in_timer_clocks = (uint32_t)(((uint64_t)HAL_TC_TIMER_CLOCK_FREQUENCY * deadline_in_us) / 1000000);
+	
+	//the channel is only configured here. It's started each time a small write is held back
+	HAL_TC_INITIALIZE_PERIODIC_INTERRUPT(tc_port_base_addr, tc_channel, period_in_timer_clocks);
+	HAL_TC_STOP(tc_port_base_addr, tc_channel);
+	
+	this->tx_coalescing_timer_armed = false;
+	this->tx_coalescing_timer_base_address = tc_port_base_addr;
+}
+
+void serial_circular_buffer::disable_tx_coalescing(void)
+{
+	if(this->tx_coalescing_timer_base_address != NULL)
+	{
+		HAL_TC_STOP(this->tx_coalescing_timer_base_address, this->tx_coalescing_timer_channel);
+		this->tx_coalescing_timer_base_address = NULL;
+		this->tx_coalescing_timer_armed = false;
+		this->start_tx_if_idle(false);
+	}
+}
+
+void serial_circular_buffer::enable_tx_pacing(tc_t tc_port_base_addr, uint32_t tc_channel, uint32_t bytes_per_second, uint32_t burst_size_in_bytes)
+{
+	uint32_t period_in_timer_clocks = 0;
+	
+	this->disable_tx_pacing();
+	
+	if((bytes_per_second == 0) || (burst_size_in_bytes == 0))
+	{
+		return;
+	}
+	
+	if(burst_size_in_bytes > HAL_PDC_MAX_TRANSFER_SIZE)
+	{
+		burst_size_in_bytes = HAL_PDC_MAX_TRANSFER_SIZE;
+	}
+	
+	this->tx_pacing_timer_channel = tc_channel;
+	this->tx_pacing_burst_size = burst_size_in_bytes;
+	this->tx_pacing_tokens = burst_size_in_bytes;
+	this->tx_pacing_waiting = false;
+	
+	//one burst worth of bytes is released each period, which averages out to bytes_per_second
+	period_in_timer_clocks = (uint32_t)(((uint64_t)HAL_TC_TIMER_CLOCK_FREQUENCY * burst_size_in_bytes) / bytes_per_second);
+	
+	this->tx_pacing_timer_base_address = tc_port_base_addr;
+	
+	HAL_TC_INITIALIZE_PERIODIC_INTERRUPT(tc_port_base_addr, tc_channel, period_in_timer_clocks);
+}
+
+void serial_circular_buffer::disable_tx_pacing(void)
+{
+	if(this->tx_pacing_timer_base_address != NULL)
+	{
+		HAL_TC_STOP(this->tx_pacing_timer_base_address, this->tx_pacing_timer_channel);
+		this->tx_pacing_timer_base_address = NULL;
+		
+		//if the transmitter was waiting for the next tick, it's still claimed, so restart it directly
+		if(this->clear_tx_pacing_waiting())
+		{
+			this->start_next_tx_transfer();
+		}
+	}
+}
+
+void serial_circular_buffer::set_tx_overflow_mode(tx_overflow_mode_t overflow_mode, uint32_t blocking_timeout_in_us)
+{
+	HAL_TIMESTAMP_ENABLE();
+	
+	this->tx_overflow_mode = overflow_mode;
+	this->tx_blocking_timeout_in_cycles = blocking_timeout_in_us * (SystemCoreClock / 1000000);
+}
+#pragma endregion Public Class Member Functions
+
+#pragma region Private Class Member Functions
+uint32_t serial_circular_buffer::get_rx_buffer_head_index(void)
+{
+	return(HAL_PDC_READ_RECEIVE_POINTER_VALUE() - (uint32_t)this->rx_buffer);
+}
+
+uint32_t serial_circular_buffer::get_rx_transfer_size(uint32_t start_index)
+{
+	if((start_index + this->rx_pdc_transfer_size) > this->rx_buffer_size)
+	{
+		return(this->rx_buffer_size - start_index);
+	}
+	
+	return(this->rx_pdc_transfer_size);
+}
+
+void serial_circular_buffer::restart_rx_pdc(void)
+{
+	uint32_t restart_index = 0;
+	uint32_t restart_size = 0;
+	
+	//in RX_PDC_MODE_WITH_NEXT, the PDC only stops once it has also completed the queued transfer. Account for the switch over into it that the ISR missed
+	if((this->rx_pdc_mode == RX_PDC_MODE_WITH_NEXT) && (this->rx_queued_transfer_index == 0))
+	{
+		this->rx_rollover_count++;
+	}
+	
+	//the PDC pointer is left at the end of the completed transfer, so restart from there. If that's the end of the buffer, roll over to the beginning
+	restart_index = this->get_rx_buffer_head_index();
+	
+	if(restart_index >= this->rx_buffer_size)
+	{
+		restart_index = 0;
+		this->rx_rollover_count++;
+	}
+	
+	restart_size = this->get_rx_transfer_size(restart_index);
+	
+	if(this->rx_pdc_mode == RX_PDC_MODE_WITH_NEXT)
+	{
+		this->rx_queued_transfer_index = this->wrap_rx_index(restart_index + restart_size);
+		this->rx_queued_transfer_size = this->get_rx_transfer_size(this->rx_queued_transfer_index);
+		HAL_PDC_RX_INIT_WITH_NEXT(this->pdc_peripheral_base_address, (uint32_t)&(this->rx_buffer[restart_index]), restart_size, 
+								  (uint32_t)&(this->rx_buffer[this->rx_queued_transfer_index]), this->rx_queued_transfer_size);
+	}
+	else
+	{
+		HAL_PDC_RX_INIT_NO_NEXT(this->pdc_peripheral_base_address, (uint32_t)&(this->rx_buffer[restart_index]), restart_size);
+	}
+}
+
+uint64_t serial_circular_buffer::get_rx_snapshot(uint32_t *head_index)
+{
+	uint32_t rollover_count = 0;
+	uint32_t next_counter_value = 0;
+	uint32_t pending_rollover = 0;
+	
+	do
+	{
+		rollover_count = this->rx_rollover_count;
+		next_counter_value = HAL_PDC_READ_RECEIVE_NEXT_COUNTER_VALUE();
+		*head_index = this->get_rx_buffer_head_index();
+		
+		/*in RX_PDC_MODE_WITH_NEXT, the PDC switches over to the queued transfer on its own and clears the next counter. If the queued transfer starts at 
+		  the beginning of the buffer, that's a roll over the ISR hasn't counted yet */
+		pending_rollover = ((this->rx_pdc_mode == RX_PDC_MODE_WITH_NEXT) && (next_counter_value == 0) && (this->rx_queued_transfer_index == 0)) ? 1 : 0;
+		
+	} while((rollover_count != this->rx_rollover_count) || (next_counter_value != HAL_PDC_READ_RECEIVE_NEXT_COUNTER_VALUE()));
+	
+	return(((uint64_t)(rollover_count + pending_rollover) * this->rx_buffer_size) + *head_index);
+}
+
+void serial_circular_buffer::record_rx_timestamp(uint64_t number_of_received_bytes)
+{
+	uint32_t next_head_index = 0;
+	uint32_t interrupt_state = 0;
+	
+	if(this->rx_timestamp_buffer == NULL)
+	{
+		return;
+	}
+	
+	HAL_ENTER_CRITICAL_SECTION(interrupt_state);
+	
+	next_head_index = (this->rx_timestamp_head_index + 1) % this->rx_timestamp_buffer_size;
+	
+	//only record a timestamp if new bytes have arrived since the last one, and there's room for it
+	if(((uint32_t)number_of_received_bytes != this->rx_last_timestamped_number_of_received_bytes) && (next_head_index != this->rx_timestamp_tail_index))
+	{
+		this->rx_timestamp_buffer[this->rx_timestamp_head_index].number_of_received_bytes = (uint32_t)number_of_received_bytes;
+		this->rx_timestamp_buffer[this->rx_timestamp_head_index].timestamp = HAL_TIMESTAMP_READ();
+		this->rx_last_timestamped_number_of_received_bytes = (uint32_t)number_of_received_bytes;
+		this->rx_timestamp_head_index = next_head_index;
+	}
+	
+	HAL_EXIT_CRITICAL_SECTION(interrupt_state);
+}
+
+void serial_circular_buffer::increment_rx_buffer_tail_index(uint32_t increment_index)
+{
+	this->rx_buffer_tail_index = this->wrap_rx_index(this->rx_buffer_tail_index + increment_index);
+	this->rx_bytes_consumed += increment_index;
+}
+
+uint32_t serial_circular_buffer::get_number_of_unsent_bytes()
+{
+	int32_t difference = 0;
+	
+	difference = this->tx_buffer_head_index - this->tx_buffer_tail_index;
+	
+	//the following conditional check handles the scenario where the head index has rolled back over to beginning of buffer	
+	if(difference < 0)
+	{
+		difference += this->tx_buffer_size;
+	}
+	
+	return((uint32_t)difference);
+}
+
+uint32_t serial_circular_buffer::wait_for_tx_buffer_free_space(uint32_t number_of_bytes)
+{
+	uint32_t free_space = 0;
+	uint32_t start_time = 0;
+	
+	free_space = this->get_tx_buffer_free_space();
+	
+	//a packet that's larger than the whole buffer can never fit. Only wait for it if it's going to be partially accepted anyway, and then only until the buffer is empty
+	if(number_of_bytes >= this->tx_buffer_size)
+	{
+		if(this->tx_overflow_mode == TX_OVERFLOW_ALL_OR_NOTHING)
+		{
+			return(free_space);
+		}
+		number_of_bytes = this->tx_buffer_size - 1;
+	}
+	
+	if((free_space >= number_of_bytes) || (this->tx_blocking_timeout_in_cycles == 0))
+	{
+		return(free_space);
+	}
+	
+	start_time = HAL_TIMESTAMP_READ();
+	
+	while((free_space < number_of_bytes) && ((HAL_TIMESTAMP_READ() - start_time) < this->tx_blocking_timeout_in_cycles))
+	{
+		free_space = this->get_tx_buffer_free_space();
+	}
+	
+	return(free_space);
+}
+
+void serial_circular_buffer::register_tx_producer(void)
+{
+	uint32_t number_of_producers = 0;
+	
+	do
+	{
+		number_of_producers = HAL_LOAD_EXCLUSIVE(&(this->tx_number_of_producers)) + 1;
+	} while(HAL_STORE_EXCLUSIVE(number_of_producers, &(this->tx_number_of_producers)));
+}
+
+void serial_circular_buffer::release_tx_producer(void)
+{
+	uint32_t number_of_producers = 0;
+	uint32_t reserve_index = 0;
+	
+	do
+	{
+		number_of_producers = HAL_LOAD_EXCLUSIVE(&(this->tx_number_of_producers)) - 1;
+	} while(HAL_STORE_EXCLUSIVE(number_of_producers, &(this->tx_number_of_producers)));
+	
+	/*only the last producer to finish publishes the reserved space, so packets always become visible to the ISR in the order their space was
+	  reserved, and no thread ever has to wait on another. The space is only published if no other producer has registered in the meantime; 
+	  since any interrupt or context switch between the exclusive load and store fails the store, the check is still valid when the store succeeds */
+	if(number_of_producers == 0)
+	{
+		do
+		{
+			HAL_LOAD_EXCLUSIVE(&(this->tx_buffer_head_index));
+			
+			if(this->tx_number_of_producers != 0)
+			{
+				//the producer that registered will publish everything, including ours, once it's done
+				HAL_CLEAR_EXCLUSIVE();
+				return;
+			}
+			
+			reserve_index = this->tx_buffer_reserve_index;
+			
+		} while(HAL_STORE_EXCLUSIVE(reserve_index, &(this->tx_buffer_head_index)));
+	}
+	
+	//the transmitter has to be checked even if another producer is still registered, since it may have been left idle waiting for this producer
+	this->start_tx_if_idle(true);
+}
+
+uint32_t serial_circular_buffer::claim_tx_buffer_space(uint32_t number_of_bytes, bool accept_partial, uint32_t *start_index)
+{
+	int32_t free_space = 0;
+	
+	do
+	{
+		*start_index = HAL_LOAD_EXCLUSIVE(&(this->tx_buffer_reserve_index));
+		
+		//same calculation as get_tx_buffer_free_space(), but relative to the reserve index that was loaded exclusively
+		free_space = this->tx_buffer_release_index - *start_index;
+		
+		if(free_space <= 0)
+		{
+			free_space += this->tx_buffer_size;
+		}
+		free_space -= 1;
+		
+		if(number_of_bytes > (uint32_t)free_space)
+		{
+			number_of_bytes = accept_partial ? (uint32_t)free_space : 0;
+		}
+		
+		if(number_of_bytes == 0)
+		{
+			HAL_CLEAR_EXCLUSIVE();
+			return(0);
+		}
+		
+	} while(HAL_STORE_EXCLUSIVE(this->wrap_tx_index(*start_index + number_of_bytes), &(this->tx_buffer_reserve_index)));
+	
+	return(number_of_bytes);
+}
+
+void serial_circular_buffer::start_tx_if_idle(bool hold_small_writes)
+{
+	uint32_t number_of_unsent_bytes = 0;
+	
+	//once the transmitter is busy, the ISR picks up everything that's queued up when the current transfer is done, so there's nothing to hold back
+	if(hold_small_writes && (this->tx_coalescing_timer_base_address != NULL) && !this->pdc_Tx_in_progress &&
+	   (this->tx_priority_head_index == this->tx_priority_tail_index) && (this->tx_descriptor_head_index == this->tx_descriptor_tail_index))
+	{
+		number_of_unsent_bytes = this->get_number_of_unsent_bytes();
+		
+		if((number_of_unsent_bytes != 0) && (number_of_unsent_bytes < this->tx_coalescing_threshold))
+		{
+			//only the first held back write arms the deadline, so later ones can't push it out
+			do
+			{
+				if(HAL_LOAD_EXCLUSIVE(&(this->tx_coalescing_timer_armed)))
+				{
+					HAL_CLEAR_EXCLUSIVE();
+					return;
+				}
+			} while(HAL_STORE_EXCLUSIVE(true, &(this->tx_coalescing_timer_armed)));
+			
+			HAL_TC_RESTART(this->tx_coalescing_timer_base_address, this->tx_coalescing_timer_channel);
+			return;
+		}
+	}
+	
+	//only initiate a new transmit if the PDC not currently transmitting any data, otherwise the ISR will pick up the new data once the current transfer is done
+	do
+	{
+		if(HAL_LOAD_EXCLUSIVE(&(this->pdc_Tx_in_progress)))
+		{
+			HAL_CLEAR_EXCLUSIVE();
+			return;
+		}
+	} while(HAL_STORE_EXCLUSIVE(true, &(this->pdc_Tx_in_progress)));
+	
+	this->start_next_tx_transfer();
+}
+
+void serial_circular_buffer::get_tx_buffer_spans(uint32_t start_index, uint32_t number_of_bytes, tx_buffer_spans_t *spans)
+{
+	spans->first_block_ptr = &(this->pdc_tx_buffer[start_index]);
+	spans->second_block_ptr = this->pdc_tx_buffer;
+	
+	if((number_of_bytes + start_index) > this->tx_buffer_size)
+	{
+		spans->first_block_size = this->tx_buffer_size - start_index;
+		spans->second_block_size = number_of_bytes - spans->first_block_size;
+	}
+	else
+	{
+		spans->first_block_size = number_of_bytes;
+		spans->second_block_size = 0;
+	}
+}
+
+void serial_circular_buffer::write_tx_buffer_spans(const tx_buffer_spans_t *spans, uint32_t offset, const char *data, uint32_t number_of_bytes)
+{
+	uint32_t first_block_bytes_to_write = 0;
+	
+	//copy whatever part of the bytes lands in the first contiguous block
+	if(offset < spans->first_block_size)
+	{
+		first_block_bytes_to_write = spans->first_block_size - offset;
+		
+		if(first_block_bytes_to_write > number_of_bytes)
+		{
+			first_block_bytes_to_write = number_of_bytes;
+		}
+		
+		memcpy(&(spans->first_block_ptr[offset]), data, first_block_bytes_to_write);
+		offset += first_block_bytes_to_write;
+	}
+	
+	//if applicable, copy the remaining bytes to the beginning of the circular buffer
+	if(number_of_bytes > first_block_bytes_to_write)
+	{
+		memcpy(&(spans->second_block_ptr[offset - spans->first_block_size]), &(data[first_block_bytes_to_write]), number_of_bytes - first_block_bytes_to_write);
+	}
+}
+
+uint32_t serial_circular_buffer::transmit_unsent_bytes(char *buffer, uint32_t buffer_size, volatile uint32_t *tail_index, uint32_t end_index, uint32_t max_number_of_bytes)
+{
+	int32_t number_of_bytes_to_send = 0;
+	uint32_t initial_tail_index = 0;
+	
+	initial_tail_index = *tail_index;
+	number_of_bytes_to_send = end_index - initial_tail_index;
+	
+	//the following conditional check handles the scenario where the end index has rolled back over to beginning of buffer
+	if(number_of_bytes_to_send < 0)
+	{
+		number_of_bytes_to_send += buffer_size;
+	}
+	
+	//the rest is picked up by the ISR once this transfer is done
+	if((uint32_t)number_of_bytes_to_send > max_number_of_bytes)
+	{
+		number_of_bytes_to_send = max_number_of_bytes;
+	}
+	
+	//the pacing tokens are deducted before the PDC is started, since a short transfer raises TXBUFE almost straight away
+	this->consume_tx_pacing_tokens((uint32_t)number_of_bytes_to_send);
+	
+	//"pre-load" tail so when ISR fires, it will see we've already transmitted the "number_of_bytes_to_send" amount of bytes. It can wrap at most once
+	*tail_index = ((initial_tail_index + number_of_bytes_to_send) >= buffer_size) ? (initial_tail_index + number_of_bytes_to_send - buffer_size) : (initial_tail_index + number_of_bytes_to_send);
+	
+	if((initial_tail_index + number_of_bytes_to_send) > buffer_size)	//check for rollover (i.e. bytes to send at the end of the buffer, and the beginning)
+	{
+		//if packet is split up between end and beginning of buffer, chain the beginning of the buffer onto the end of the buffer with the PDC next pointer
+		this->initiate_PDC_Tx(&(buffer[initial_tail_index]), buffer_size - initial_tail_index,
+							  buffer, (initial_tail_index + number_of_bytes_to_send) - buffer_size);
+	}
+	else
+	{
+		this->initiate_PDC_Tx(&(buffer[initial_tail_index]), number_of_bytes_to_send);
+	}
+	
+	return((uint32_t)number_of_bytes_to_send);
+}
+
+bool serial_circular_buffer::start_next_tx_transfer(void)
+{
+	tx_descriptor_t *descriptor;
+	uint32_t end_index = 0;
+	uint32_t number_of_bytes_to_send = 0;
+	uint32_t tail_index = 0;
+	uint32_t max_number_of_bytes = HAL_PDC_MAX_TRANSFER_SIZE;
+	uint32_t bulk_chunk_size = 0;
+	
+	//with pacing enabled, each transfer is limited to the bytes released by the pacing timer so far
+	if(this->tx_pacing_timer_base_address != NULL)
+	{
+		max_number_of_bytes = this->tx_pacing_tokens;
+		
+		if((max_number_of_bytes == 0) && this->is_tx_data_queued())
+		{
+			/*the transmitter stays claimed while it waits, so the pacing timer is the only one that restarts it. TXBUFE is disabled first, otherwise 
+			  a pacing period that ends in between could restart the transmitter and then have its TXBUFE interrupt disabled underneath it */
+			HAL_UART_DISABLE_TX_BUFFER_EMPTY_INTERRUPT();
+			this->tx_pacing_waiting = true;
+			return(true);
+		}
+	}
+	
+	bulk_chunk_size = (this->tx_bulk_chunk_size < max_number_of_bytes) ? this->tx_bulk_chunk_size : max_number_of_bytes;
+	
+	//priority packets are sent at the first transfer boundary, ahead of everything else
+	if((this->tx_priority_buffer != NULL) && (this->tx_priority_head_index != this->tx_priority_tail_index))
+	{
+		this->pdc_Tx_in_progress = true;
+		this->transmit_unsent_bytes(this->tx_priority_buffer, this->tx_priority_buffer_size, &(this->tx_priority_tail_index), this->tx_priority_head_index, max_number_of_bytes);
+		return(true);
+	}
+	
+	end_index = this->tx_buffer_head_index;
+	tail_index = this->tx_buffer_tail_index;
+	
+	/*a descriptor that another thread is still filling in is passed over for now. That thread holds the head index back, so the bytes up to the
+	  head index are all queued up ahead of the descriptor anyway */
+	if((this->tx_descriptor_queue != NULL) && (this->tx_descriptor_tail_index != this->tx_descriptor_head_index) &&
+	   this->tx_descriptor_queue[this->tx_descriptor_tail_index].ready)
+	{
+		descriptor = &(this->tx_descriptor_queue[this->tx_descriptor_tail_index]);
+		
+		if(descriptor->tx_buffer_position == tail_index)
+		{
+			//every byte queued up ahead of the descriptor has been sent, so it's the descriptor's turn. Blocks larger than a bulk chunk are sent in pieces
+			number_of_bytes_to_send = descriptor->size - this->tx_descriptor_offset;
+			
+			if(number_of_bytes_to_send > bulk_chunk_size)
+			{
+				number_of_bytes_to_send = bulk_chunk_size;
+			}
+			
+			//the bookkeeping is done before the PDC is started, since the TXBUFE interrupt may fire as soon as it is
+			this->consume_tx_pacing_tokens(number_of_bytes_to_send);
+			this->tx_descriptor_offset += number_of_bytes_to_send;
+			this->tx_descriptor_in_flight = true;
+			this->pdc_Tx_in_progress = true;
+			this->initiate_PDC_Tx((char *)&(descriptor->data[this->tx_descriptor_offset - number_of_bytes_to_send]), number_of_bytes_to_send);
+			return(true);
+		}
+		
+		/*bytes queued up after the descriptor have to wait until the descriptor has been sent. The descriptor's position may be past the head index
+		  while another producer is still writing the bytes ahead of it, in which case only the bytes up to the head index can be sent */
+		if(this->wrap_tx_index(descriptor->tx_buffer_position + this->tx_buffer_size - tail_index) < this->wrap_tx_index(end_index + this->tx_buffer_size - tail_index))
+		{
+			end_index = descriptor->tx_buffer_position;
+		}
+	}
+	
+	if(end_index != tail_index)
+	{
+		this->pdc_Tx_in_progress = true;
+		this->transmit_unsent_bytes(this->pdc_tx_buffer, this->tx_buffer_size, &(this->tx_buffer_tail_index), end_index, bulk_chunk_size);
+		return(true);
+	}
+	
+	this->pdc_Tx_in_progress = false;
+	HAL_UART_DISABLE_TX_BUFFER_EMPTY_INTERRUPT();
+	
+	return(false);
+}
+
+bool serial_circular_buffer::is_tx_data_queued(void)
+{
+	return((this->tx_buffer_head_index != this->tx_buffer_tail_index) ||
+		   (this->tx_priority_head_index != this->tx_priority_tail_index) ||
+		   (this->tx_descriptor_head_index != this->tx_descriptor_tail_index));
+}
+
+bool serial_circular_buffer::clear_tx_pacing_waiting(void)
+{
+	//only one of the pacing timer, disable_tx_pacing() and abort_and_transmit_urgent() may take over a waiting transmitter
+	do
+	{
+		if(!HAL_LOAD_EXCLUSIVE(&(this->tx_pacing_waiting)))
+		{
+			HAL_CLEAR_EXCLUSIVE();
+			return(false);
+		}
+	} while(HAL_STORE_EXCLUSIVE(false, &(this->tx_pacing_waiting)));
+	
+	return(true);
+}
+
+void serial_circular_buffer::consume_tx_pacing_tokens(uint32_t number_of_bytes)
+{
+	uint32_t tokens = 0;
+	
+	if(this->tx_pacing_timer_base_address == NULL)
+	{
+		return;
+	}
+	
+	//the pacing timer may refill the tokens at any time, possibly from an interrupt with a different priority
+	do
+	{
+		tokens = HAL_LOAD_EXCLUSIVE(&(this->tx_pacing_tokens));
+		tokens = (number_of_bytes < tokens) ? (tokens - number_of_bytes) : 0;
+	} while(HAL_STORE_EXCLUSIVE(tokens, &(this->tx_pacing_tokens)));
+}
+
+void serial_circular_buffer::complete_tx_descriptor(void)
+{
+	tx_descriptor_t *descriptor;
+	serial_circular_buffer_callback_t callback;
+	void *callback_context;
+	
+	descriptor = &(this->tx_descriptor_queue[this->tx_descriptor_tail_index]);
+	
+	//large blocks are sent in pieces, so the descriptor is only complete once its last piece has been sent
+	if(this->tx_descriptor_offset < descriptor->size)
+	{
+		return;
+	}
+	
+	//save off the callback before freeing up the descriptor, since the application may reuse it as soon as it's free
+	callback = descriptor->callback;
+	callback_context = descriptor->callback_context;
+	
+	this->tx_descriptor_offset = 0;
+	descriptor->ready = false;
+	this->tx_descriptor_tail_index = (this->tx_descriptor_tail_index + 1) % this->tx_descriptor_queue_size;
+	
+	if(callback != NULL)
+	{
+		callback(callback_context);
+	}
+}
+
+void serial_circular_buffer::initiate_PDC_Tx(char *pointer_to_Tx_buffer, uint32_t bytes_to_transfer, char *pointer_to_next_Tx_buffer, uint32_t next_bytes_to_transfer)
+{
+	if(next_bytes_to_transfer)
+	{
+		HAL_PDC_TX_INIT_WITH_NEXT(this->pdc_peripheral_base_address, (uint32_t)(pointer_to_Tx_buffer), bytes_to_transfer, (uint32_t)(pointer_to_next_Tx_buffer), next_bytes_to_transfer);
+	}
+	else
+	{
+		HAL_PDC_TX_INIT_NO_NEXT(this->pdc_peripheral_base_address, (uint32_t)(pointer_to_Tx_buffer), bytes_to_transfer);	
+	}
+	HAL_UART_ENABLE_TX_BUFFER_EMPTY_INTERRUPT();
+
+}
+#pragma endregion Private Class Member Functions
+
+#pragma region UART ISR Handlers
+void UART0_Handler(void)
+{
+	UART0_ISR_instance_ptr->serial_circular_buffer_irq_handler();
+}
+
+void UART1_Handler(void)
+{
+	UART1_ISR_instance_ptr->serial_circular_buffer_irq_handler();
+}
+
+void serial_circular_buffer::rx_idle_timer_irq_handler(void)
+{
+	uint64_t number_of_received_bytes = 0;
+	
+	//reading the status register also clears the interrupt
+	if((this->idle_timer_base_address == NULL) || !HAL_TC_IS_PERIOD_ELAPSED(this->idle_timer_base_address, this->idle_timer_channel))
+	{
+		return;
+	}
+	
+	number_of_received_bytes = this->get_total_number_of_received_bytes();
+	
+	if(number_of_received_bytes != this->rx_idle_last_number_of_received_bytes)
+	{
+		//bytes have arrived during the last period, so the line isn't idle yet
+		this->rx_idle_last_number_of_received_bytes = number_of_received_bytes;
+		this->rx_activity_since_idle = true;
+		this->record_rx_timestamp(number_of_received_bytes);
+	}
+	else if(this->rx_activity_since_idle)
+	{
+		//a full period has passed with no new bytes after a burst of activity. Only report it once per burst
+		this->rx_activity_since_idle = false;
+		
+		if(this->rx_idle_callback != NULL)
+		{
+			this->rx_idle_callback(this->rx_idle_callback_context);
+		}
+	}
+}
+
+void serial_circular_buffer::tx_coalescing_timer_irq_handler(void)
+{
+	//reading the status register also clears the interrupt
+	if((this->tx_coalescing_timer_base_address == NULL) || !HAL_TC_IS_PERIOD_ELAPSED(this->tx_coalescing_timer_base_address, this->tx_coalescing_timer_channel))
+	{
+		return;
+	}
+	
+	//the deadline is one-shot. The next held back write re-arms it
+	HAL_TC_STOP(this->tx_coalescing_timer_base_address, this->tx_coalescing_timer_channel);
+	this->tx_coalescing_timer_armed = false;
+	
+	this->start_tx_if_idle(false);
+}
+
+void serial_circular_buffer::tx_pacing_timer_irq_handler(void)
+{
+	//reading the status register also clears the interrupt
+	if((this->tx_pacing_timer_base_address == NULL) || !HAL_TC_IS_PERIOD_ELAPSED(this->tx_pacing_timer_base_address, this->tx_pacing_timer_channel))
+	{
+		return;
+	}
+	
+	//unused bytes don't carry over past one burst, so an idle period can't be followed by more than a burst at full line rate
+	this->tx_pacing_tokens = this->tx_pacing_burst_size;
+	
+	if(this->clear_tx_pacing_waiting())
+	{
+		this->start_next_tx_transfer();
+	}
+}
+
+void serial_circular_buffer::serial_circular_buffer_irq_handler(void)
+{
+	bool		rx_transfer_complete = false;
+	bool		tx_transfer_complete = false;
+	uint32_t	interrupt_state = 0;
+
+	/*the roll over count, queued transfer index and PDC counters only make sense together, so they're updated with interrupts masked. Otherwise a TC interrupt
+	  taking a snapshot part way through (see get_rx_snapshot()) would count the roll over twice, or miss it */
+	HAL_ENTER_CRITICAL_SECTION(interrupt_state);
+	
+	if(HAL_UART_IS_RECEIVE_BUFFER_FULL())
+	{
+		/*if here, the Rx PDC has run out of transfers and stopped. In RX_PDC_MODE_NO_NEXT this happens at the end of every transfer. In RX_PDC_MODE_WITH_NEXT 
+		  it only happens if the ISR was held off long enough for both the current and queued transfers to complete */
+		this->restart_rx_pdc();
+		rx_transfer_complete = true;
+	}
+	else if((this->rx_pdc_mode == RX_PDC_MODE_WITH_NEXT) && HAL_UART_IS_END_OF_RX_TRANSFER())
+	{
+		//if here, the PDC has already switched over to the queued transfer on its own. Queue up the transfer that follows it
+		if(this->rx_queued_transfer_index == 0)
+		{
+			this->rx_rollover_count++;
+		}
+		
+		this->rx_queued_transfer_index = this->wrap_rx_index(this->rx_queued_transfer_index + this->rx_queued_transfer_size);
+		this->rx_queued_transfer_size = this->get_rx_transfer_size(this->rx_queued_transfer_index);
+		HAL_PDC_RX_LOAD_NEXT(this->pdc_peripheral_base_address, (uint32_t)&(this->rx_buffer[this->rx_queued_transfer_index]), this->rx_queued_transfer_size);
+		rx_transfer_complete = true;
+	}
+	
+	HAL_EXIT_CRITICAL_SECTION(interrupt_state);
+	
+	if(rx_transfer_complete)
+	{
+		if(this->rx_timestamp_buffer != NULL)
+		{
+			this->record_rx_timestamp(this->get_total_number_of_received_bytes());
+		}
+		
+		if((this->rx_watermark_callback != NULL) && (this->get_number_of_unread_bytes() >= this->rx_watermark))
+		{
+			this->rx_watermark_callback(this->rx_watermark_callback_context);
+		}
+	}
+
+	/*TXBUFE stays set the whole time the Tx PDC is idle, so it's only acted on while its interrupt is enabled. Otherwise, an Rx interrupt could
+	  preempt start_tx_if_idle() part way through starting a transfer and release or restart the bytes it's handing to the PDC.
+	  The interrupt is masked again while the next transfer is worked out, so abort_and_transmit_urgent() called from a higher priority interrupt
+	  sees a transmitter that's claimed but not started yet, rather than a finished transfer it can take over and then have overwritten */
+	HAL_ENTER_CRITICAL_SECTION(interrupt_state);
+	
+	if(HAL_UART_IS_TX_BUFFER_EMPTY_INTERRUPT_ENABLED() && HAL_UART_IS_TRANSMIT_BUFFER_EMPTY())
+	{
+		HAL_UART_DISABLE_TX_BUFFER_EMPTY_INTERRUPT();
+		tx_transfer_complete = true;
+	}
+	
+	HAL_EXIT_CRITICAL_SECTION(interrupt_state);
+	
+	if(tx_transfer_complete)
+	{
+		if(this->tx_urgent_in_flight && ((this->tx_interrupted_size != 0) || (this->tx_interrupted_next_size != 0)))
+		{
+			//the urgent frame has been sent, so resume the transfer it interrupted from the byte it stopped at
+			this->tx_urgent_in_flight = false;
+			
+			if(this->tx_interrupted_size != 0)
+			{
+				this->initiate_PDC_Tx(this->tx_interrupted_pointer, this->tx_interrupted_size, this->tx_interrupted_next_pointer, this->tx_interrupted_next_size);
+			}
+			else
+			{
+				this->initiate_PDC_Tx(this->tx_interrupted_next_pointer, this->tx_interrupted_next_size);
+			}
+		}
+		else
+		{
+			this->tx_urgent_in_flight = false;
+			
+			//every byte handed to the PDC so far has been transmitted, so that space can be reused
+			this->tx_buffer_release_index = this->tx_buffer_tail_index;
+			this->tx_priority_release_index = this->tx_priority_tail_index;
+			
+			if(this->tx_descriptor_in_flight)
+			{
+				this->tx_descriptor_in_flight = false;
+				this->complete_tx_descriptor();
+			}
+			
+			/*the PDC is done, but the last byte is still being shifted out. Wait for TXEMPTY before reporting the end of transmission. This is only
+			  done here, after a transfer, since TXEMPTY is already set on a line that was idle to begin with */
+			if(!this->start_next_tx_transfer() && (this->tx_complete_callback != NULL))
+			{
+				HAL_UART_ENABLE_TX_EMPTY_INTERRUPT();
+			}
+		}
+	}
+	
+	if(HAL_UART_IS_TX_EMPTY_INTERRUPT_ENABLED() && HAL_UART_IS_TRANSMITTER_EMPTY())
+	{
+		HAL_UART_DISABLE_TX_EMPTY_INTERRUPT();
+		
+		//if a new transfer has been started in the meantime, the transmitter isn't idle after all. The notification comes at the end of that one instead
+		if(!this->pdc_Tx_in_progress && (this->tx_complete_callback != NULL))
+		{
+			this->tx_complete_callback(this->tx_complete_callback_context);
 		}
 	}
 }